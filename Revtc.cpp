@@ -1,10 +1,18 @@
 #include "Revtc.h"
+#include "RevtcMechanics.h"
 #include <algorithm>
 #include <numeric>
+#include <cstring>
+#include <cmath>
+#include <functional>
+#include <thread>
 
 namespace Revtc {
+	//By subgroup, then agent table order. players is unordered and its iteration order changes when a Parser
+	//is reused, so the tie break keeps log.players the same for every parse of a log.
 	inline bool operator<(const Player& lhs, const Player& rhs) {
-        return lhs.subgroup < rhs.subgroup;
+        if (lhs.subgroup != rhs.subgroup) return lhs.subgroup < rhs.subgroup;
+        return lhs.slot < rhs.slot;
     }
 
     inline bool operator<(const BoonStack& lhs, const BoonStack& rhs) {
@@ -15,77 +23,286 @@ namespace Revtc {
             : buf(buf)
             , buf_len(len)
             , boss_addr(0)
+            , agent_by_index(memoryCounter(MemoryPool::AGENTS))
+            , threads(1)
+            , agents(memoryCounter(MemoryPool::AGENTS))
+            , players(memoryCounter(MemoryPool::PLAYERS))
+            , skills(memoryCounter(MemoryPool::SKILLS))
+            , events(memoryCounter(MemoryPool::EVENTS))
+            , buff_agents(memoryCounter(MemoryPool::BUFF_STACKS))
+            , buff_tracks(memoryCounter(MemoryPool::BUFF_STACKS))
+            , buff_stacks(memoryCounter(MemoryPool::BUFF_STACKS))
+            , active_stacks(memoryCounter(MemoryPool::REPLAY))
+            , skill_ids(memoryCounter(MemoryPool::SKILLS))
     {
+#ifdef REVTC_MEMORY_STATS
+        for (MemoryCounter& counter : memory_pools) {
+            counter.parent = &memory_total;
+        }
+#endif
     }
 
     Parser::~Parser()
     {
     }
 
+    MemoryCounter* Parser::memoryCounter(MemoryPool pool)
+    {
+#ifdef REVTC_MEMORY_STATS
+        return &memory_pools[(size_t)pool];
+#else
+        (void)pool;
+        return nullptr;
+#endif
+    }
+
+    MemoryReport Parser::memoryReport() const
+    {
+        MemoryReport report{};
+        report.events = events.size();
+#ifdef REVTC_MEMORY_STATS
+        report.total = memory_total.usage();
+        for (size_t i = 0; i < (size_t)MemoryPool::COUNT; ++i) {
+            report.pools[i] = memory_pools[i].usage();
+        }
+#endif
+        return report;
+    }
+
+    const char* MemoryReport::name(MemoryPool pool)
+    {
+        switch (pool) {
+            case MemoryPool::AGENTS: return "agents";
+            case MemoryPool::PLAYERS: return "players";
+            case MemoryPool::SKILLS: return "skills";
+            case MemoryPool::EVENTS: return "events";
+            case MemoryPool::BUFF_STACKS: return "buff_stacks";
+            case MemoryPool::REPLAY: return "replay";
+            default: return "unknown";
+        }
+    }
+
+    void Parser::reset(const unsigned char* buf, size_t len)
+    {
+        this->buf = buf;
+        buf_len = len;
+        boss_addr = 0;
+#ifdef REVTC_MEMORY_STATS
+        memory_total.restart();
+        for (MemoryCounter& counter : memory_pools) {
+            counter.restart();
+        }
+#endif
+
+        //Containers are emptied but keep their capacity; map nodes are parked for reuse with everything they own
+        while (!agents.empty()) {
+            spare_agents.push_back(agents.extract(agents.begin()));
+        }
+        while (!players.empty()) {
+            spare_players.push_back(players.extract(players.begin()));
+        }
+        while (!skills.empty()) {
+            spare_skills.push_back(skills.extract(skills.begin()));
+        }
+        instances.clear();
+        events.clear();
+        buff_agents.clear();
+        buff_tracks.clear();
+        buff_stacks.clear();
+        skill_ids.clear();
+        casts.clear();
+        damage_taken.clear();
+        agent_by_index.clear();
+    }
+
+    //Inserts key, reusing a parked node (and the capacity of everything it owns) when there is one.
+    //Returns nullptr if the key is already present.
+    template<typename Map>
+    static typename Map::mapped_type* acquire(Map& map, std::vector<typename Map::node_type>& spare, const typename Map::key_type& key)
+    {
+        if (spare.empty()) {
+            auto result = map.emplace(key, typename Map::mapped_type{});
+            return result.second ? &result.first->second : nullptr;
+        }
+        typename Map::node_type node = std::move(spare.back());
+        spare.pop_back();
+        node.key() = key;
+        auto result = map.insert(std::move(node));
+        if (!result.inserted) {
+            spare.push_back(std::move(result.node));
+            return nullptr;
+        }
+        return &result.position->second;
+    }
+
+    //Unaligned-safe read. Callers check the section bounds once, not per field.
+    template<typename T>
+    static inline T load(const unsigned char* p)
+    {
+        T value;
+        memcpy(&value, p, sizeof(T));
+        return value;
+    }
+
+    //Early exit from parse with the reason the log is invalid
+    static void fail(Log& log, const char* error)
+    {
+        log.valid = false;
+        log.error = error;
+        log.players.clear();
+    }
+
+    //Value-initializes a recycled entry while keeping the buffers it owns
+    static void recycle(Agent& agent)
+    {
+        std::string name = std::move(agent.name);
+        agent = Agent{};
+        agent.name = std::move(name);
+        agent.name.clear();
+    }
+
+    static void recycle(Player& player)
+    {
+        Player fresh{};
+        fresh.name.swap(player.name);
+        fresh.account.swap(player.account);
+        fresh.profession_name.swap(player.profession_name);
+        fresh.profession_name_short.swap(player.profession_name_short);
+        fresh.elite_spec_name.swap(player.elite_spec_name);
+        fresh.elite_spec_name_short.swap(player.elite_spec_name_short);
+        fresh.slaves.swap(player.slaves);
+        fresh.buffs.swap(player.buffs);
+        fresh.casts.swap(player.casts);
+        fresh.damage_taken.swap(player.damage_taken);
+        fresh.note.swap(player.note);
+        fresh.name.clear();
+        fresh.account.clear();
+        fresh.profession_name.clear();
+        fresh.profession_name_short.clear();
+        fresh.elite_spec_name.clear();
+        fresh.elite_spec_name_short.clear();
+        fresh.slaves.clear();
+        fresh.buffs.clear();
+        fresh.casts.clear();
+        fresh.damage_taken.clear();
+        fresh.note.clear();
+        player = std::move(fresh);
+    }
+
     Log Parser::parse()
     {
         Log log;
-        log.area_id = (BossID) 0;
-        uint32_t index = 0;
+        parse(buf, buf_len, log);
+        return log;
+    }
 
-        /* Header */
-        // EVTC + Version - 12 bytes
-        std::string evtc = std::string((char*)&buf[0], 4);
-        if (evtc != "EVTC") {
-            log.error = "Corrupted or otherwise invalid EVTC file.";
-            return log;
-        }
-        log.version = std::string((char *)&buf[4], 8);
-        log.revision = *(uint8_t*)&buf[12];
-        log.area_id = (BossID) *(uint16_t*)&buf[13];
-		log.boss_ids.emplace(static_cast<uint16_t>(log.area_id));
-		if (log.area_id == BossID::NIKARE) {
-			log.boss_ids.emplace(static_cast<uint16_t>(BossID::KENUT));
-		}
-        log.encounter_name = encounterName(log.area_id);
+    Log Parser::parse(const unsigned char* buf, size_t len)
+    {
+        Log log;
+        parse(buf, len, log);
+        return log;
+    }
+
+    void Parser::parse(const unsigned char* buf, size_t len, Log& log)
+    {
+        reset(buf, len);
+
+        //Every field of a reused Log is reset before the first early return, so a failed parse leaves nothing
+        //of the previous log behind. Players are cleared by fail() or recycled below.
+        log.version.clear();
+        log.revision = 0;
+        log.area_id = (BossID) 0;
+        log.boss_ids.clear();
+        log.encounter_name.clear();
         log.valid = false;
+        log.error.clear();
+        log.generation.player_count = 0;
+        log.generation.boon_count = 0;
+        log.generation.ms.clear();
+        log.boss_buffs.clear();
+        log.boss_health.clear();
         log.reward_at = 0;
+        log.log_start = 0;
+        log.log_end = 0;
+        log.server_start = 0;
         log.boss_lifetime = 0;
         log.boss_death = 0;
+        log.encounter_duration = 0;
+        log.encounter_duration_ms = 0;
+        size_t index = 0;
+
+        /* Header */
+        //Each section's size is checked once against buf_len up front, the loops below then read without checks.
+        // EVTC + Version - 12 bytes
+        if (buf_len < 4 || memcmp(buf, "EVTC", 4) != 0) {
+            return fail(log, "Corrupted or otherwise invalid EVTC file.");
+        }
+        if (buf_len < 20) {
+            return fail(log, "EVTC header is truncated.");
+        }
+        log.version.assign((const char *)&buf[4], 8);
+        log.revision = buf[12];
+        log.area_id = (BossID) load<uint16_t>(&buf[13]);
+        //WvW logs have no boss agent, the area id is not a species there
+        const bool has_boss = log.area_id != BossID::WVW;
+        if (has_boss) {
+            log.boss_ids.emplace(static_cast<uint16_t>(log.area_id));
+        }
+        log.encounter_name = encounterName(log.area_id);
 
         //Agent
-        uint32_t agent_count = *(uint32_t*)&buf[16];
+        uint32_t agent_count = load<uint32_t>(&buf[16]);
         index = 16 + sizeof(uint32_t);
-        for (unsigned int i = 0; i < agent_count; ++i) {
-            Agent agent{};
+        if (agent_count > (buf_len - index) / 96) {
+            return fail(log, "Agent table is truncated.");
+        }
+        for (unsigned int i = 0; i < agent_count; ++i, index += 96) {
+            uint64_t addr = load<uint64_t>(&buf[index]);
+            Agent* recycled = acquire(agents, spare_agents, addr);
+            if (!recycled) {
+                continue; //Duplicate address, the first entry wins
+            }
+            Agent& agent = *recycled;
+            recycle(agent);
+            agent.index = i;
             agent.last_aware = UINT64_MAX;
-            agent.addr = *(uint64_t*)&buf[index]; index += sizeof(uint64_t);
-            uint16_t lhf = *(uint16_t*)&buf[index];
-            uint16_t uhf = *(uint16_t*)&buf[index + sizeof(uint16_t)];
-            agent.prof = *(uint32_t*)&buf[index]; index += sizeof(uint32_t);
-            agent.is_elite = *(uint32_t*)&buf[index]; index += sizeof(uint32_t);
-            agent.toughness = *(int16_t*)&buf[index]; index += sizeof(int16_t);
-            agent.concentration = *(int16_t*)&buf[index]; index += sizeof(int16_t);
-            agent.healing = *(int16_t*)&buf[index]; index += sizeof(int16_t);
-            agent.hitbox_width = *(int16_t*)&buf[index]; index += sizeof(int16_t);
-            agent.condition = *(int16_t*)&buf[index]; index += sizeof(int16_t);
-            agent.hitbox_height = *(int16_t*)&buf[index]; index += sizeof(int16_t);
-            char *name_buf = (char *)&buf[index];
-            agent.name = std::string(name_buf); index += 64;
-            index += 4; //align padding
+            agent.addr = addr;
+            size_t field = index + sizeof(uint64_t);
+            uint16_t lhf = load<uint16_t>(&buf[field]);
+            uint16_t uhf = load<uint16_t>(&buf[field + sizeof(uint16_t)]);
+            agent.prof = load<uint32_t>(&buf[field]); field += sizeof(uint32_t);
+            agent.is_elite = load<uint32_t>(&buf[field]); field += sizeof(uint32_t);
+            agent.toughness = load<int16_t>(&buf[field]); field += sizeof(int16_t);
+            agent.concentration = load<int16_t>(&buf[field]); field += sizeof(int16_t);
+            agent.healing = load<int16_t>(&buf[field]); field += sizeof(int16_t);
+            agent.hitbox_width = load<int16_t>(&buf[field]); field += sizeof(int16_t);
+            agent.condition = load<int16_t>(&buf[field]); field += sizeof(int16_t);
+            agent.hitbox_height = load<int16_t>(&buf[field]); field += sizeof(int16_t);
+            //The name field is 64 bytes and not always terminated
+            const char *name_buf = (const char *)&buf[field];
+            const char *name_end = name_buf + 64;
+            agent.name.assign(name_buf, strnlen(name_buf, 64));
 
             //Check for player and extract info
             if (agent.is_elite != 0xFFFFFFFF) {
                 agent.agtype = AgentType::Player;
 
-                Player player{};
+                Player& player = *acquire(players, spare_players, agent.addr);
+                recycle(player);
                 player.addr = agent.addr;
                 //Character Name
-                size_t len = strlen(name_buf);
-                player.name = std::string(name_buf, len);
-                name_buf += len + 2; //Skip two since we don't want the colon
+                size_t len = strnlen(name_buf, name_end - name_buf);
+                player.name.assign(name_buf, len);
+                name_buf = std::min(name_buf + len + 2, name_end); //Skip two since we don't want the colon
                 //Account Name
-                len = strlen(name_buf);
-                player.account = std::string(name_buf, len);
-                name_buf += len + 1;
+                len = strnlen(name_buf, name_end - name_buf);
+                player.account.assign(name_buf, len);
+                name_buf = std::min(name_buf + len + 1, name_end);
                 //Subgroup
-                std::string sub(name_buf, 1);
-                player.subgroup = std::stoi(sub);
+                player.subgroup = 0;
+                for (; name_buf < name_end && *name_buf >= '0' && *name_buf <= '9'; ++name_buf) {
+                    player.subgroup = player.subgroup * 10 + (*name_buf - '0');
+                }
                 //Profession
                 player.profession = agent.prof;
                 const auto& prof = professionName(player.profession);
@@ -95,131 +312,126 @@ namespace Revtc {
                 const auto& elite = eliteSpecName(player.elite_spec);
                 player.elite_spec_name = elite.first;
                 player.elite_spec_name_short = elite.second;
+                player.slot = (uint16_t)(players.size() - 1);
 
-				Boon might = Boon{
-					(uint32_t) BoonType::MIGHT,
-					"Might",
-					true,
-					25,
-				};
-				player.boons.emplace(BoonType::MIGHT, might);
-
-				Boon quickness = Boon{
-					(uint32_t) BoonType::QUICKNESS,
-					"Quickness",
-					false,
-					5,
-				};
-				player.boons.emplace(BoonType::QUICKNESS, quickness);
-
-				Boon alacrity = Boon{
-					(uint32_t)BoonType::ALACRITY,
-					"Alacrity",
-					false,
-					9,
-				};
-				player.boons.emplace(BoonType::ALACRITY, alacrity);
-
-				Boon fury = Boon{
-					(uint32_t)BoonType::FURY,
-					"Fury",
-					false,
-					9,
-				};
-				player.boons.emplace(BoonType::FURY, fury);
-
-                players.emplace(player.addr, player);
+                agent.buff_slot = player.slot;
+                buff_agents.push_back(agent.addr);
             }
             else {
                 if (uhf == 0xFFFF) {
                     agent.agtype = AgentType::Gadget;
-					//Special Handling for Deimos (who turns into a gadget at 10%)
-					if (log.area_id == BossID::DEIMOS && agent.name == "Deimos") {
-						log.boss_ids.emplace(lhf);
-					}
                 }
                 else {
                     agent.agtype = AgentType::Npc;
                 }
+                agent.buff_slot = BUFF_NONE;
                 agent.species_id = lhf;
                 if (agent.species_id == (uint16_t)log.area_id) {
                     boss_addr = agent.addr;
                 }
             }
-
-            agents.emplace(agent.addr, agent);
+        }
+        if (has_boss && !agents.count(boss_addr)) {
+            return fail(log, "No agent in the agent table matches the encounter's boss.");
         }
 
-        //Skills
-        uint32_t skill_count = *(uint32_t*)&buf[index]; index += sizeof(uint32_t);
-        for (unsigned int i = 0; i < skill_count; ++i) {
-            Skill skill;
+        //Encounter mechanics are chosen once here and again for the extraction pass
+        const char* note_label = nullptr;
+        dispatchMechanics(log.area_id, [&](auto mechanics) {
+            using Encounter = decltype(mechanics);
+            Encounter::encounter(log);
+            for (const auto& agent_pair : agents) {
+                Encounter::agent(log, agent_pair.second);
+            }
+            note_label = Encounter::note();
+        });
 
-            skill.id = *(int32_t*)&buf[index]; index += sizeof(int32_t);
-            skill.name = std::string((char *)&buf[index]); index += 64;
+        //Skills
+        if (buf_len - index < sizeof(uint32_t)) {
+            return fail(log, "Skill table is truncated.");
+        }
+        uint32_t skill_count = load<uint32_t>(&buf[index]); index += sizeof(uint32_t);
+        if (skill_count > (buf_len - index) / 68) {
+            return fail(log, "Skill table is truncated.");
+        }
+        for (unsigned int i = 0; i < skill_count; ++i, index += 68) {
+            int32_t id = load<int32_t>(&buf[index]);
+            Skill* skill = acquire(skills, spare_skills, id);
+            if (skill) {
+                skill->id = id;
+                skill->index = (uint32_t)skill_ids.size();
+                skill_ids.push_back(id);
+                const char* name = (const char *)&buf[index + sizeof(int32_t)];
+                skill->name.assign(name, strnlen(name, 64));
+            }
+        }
 
-            skills.emplace(skill.id, skill);
+        //Bosses get tracked buffs after the players
+        for (auto& agent_pair : agents) {
+            Agent& agent = agent_pair.second;
+            if (agent.agtype != AgentType::Player && log.boss_ids.count(agent.species_id)) {
+                agent.buff_slot = (uint16_t)buff_agents.size();
+                buff_agents.push_back(agent.addr);
+            }
+        }
+        const uint16_t buff_count = BuffRegistry::count();
+        buff_tracks.resize(buff_agents.size() * buff_count);
+        for (size_t i = 0; i < buff_tracks.size(); ++i) {
+            buff_tracks[i] = Boon{ (uint16_t)(i % buff_count), 0, 0, 0.f };
         }
 
         //Events
+        //Records are fixed size, so the section splits into chunks that decode and aggregate independently.
+        //Chunk results are merged in file order, which keeps the Log identical for any thread count.
+        agent_by_index.assign(agent_count, nullptr);
+        for (auto& agent_pair : agents) {
+            agent_by_index[agent_pair.second.index] = &agent_pair.second;
+        }
+
+        const size_t stride = log.revision == 0 ? sizeof(CombatEventRev0) : sizeof(CombatEvent);
+        const size_t event_count = (buf_len - index) / stride;
+        if ((buf_len - index) % stride) {
+            //A client that crashed mid-write leaves a partial record, the whole ones before it are still good
+            log.error = "Event section ends in a partial record, which was ignored.";
+        }
+        const size_t events_offset = index;
+        events.resize(event_count);
+
+        size_t chunk_count = std::max<size_t>(1, std::min<size_t>(threads, event_count / MIN_CHUNK_EVENTS));
+        chunks.resize(chunk_count);
+        for (size_t i = 0; i < chunk_count; ++i) {
+            EventChunk& chunk = chunks[i];
+            chunk.begin = event_count * i / chunk_count;
+            chunk.end = event_count * (i + 1) / chunk_count;
+        }
+
         //First iteration - create CombatEvents
-        while (index < buf_len) {
-            CombatEvent event;
-            if (log.revision == 0) {
-                CombatEventRev0 event_rev = *(CombatEventRev0*)&buf[index];
-                index += sizeof(CombatEventRev0);
-
-                event.time = event_rev.time;
-                event.src_agent = event_rev.src_agent;
-                event.dst_agent = event_rev.dst_agent;
-                event.value = event_rev.value;
-                event.buff_dmg = event_rev.buff_dmg;
-                event.overstack_value = event_rev.overstack_value;
-                event.skillid = event_rev.skillid;
-                event.src_instid = event_rev.src_instid;
-                event.dst_instid = event_rev.dst_instid;
-                event.src_master_instid = event_rev.src_master_instid;
-                event.iff = event_rev.iff;
-                event.buff = event_rev.buff;
-                event.result = event_rev.result;
-                event.is_activation = event_rev.is_activation;
-                event.is_buffremove = event_rev.is_buffremove;
-                event.is_ninety = event_rev.is_ninety;
-                event.is_fifty = event_rev.is_fifty;
-                event.is_moving = event_rev.is_moving;
-                event.is_statechange = event_rev.is_statechange;
-                event.is_flanking = event_rev.is_flanking;
-                event.is_shields = event_rev.is_shields;
-				event.is_offcycle = event_rev.is_offcycle;
-				event.buff_instid = 0;
-            }
-            else {
-                event = *(CombatEvent*)&buf[index];
-                index += sizeof(CombatEvent);
-            }
+        forEachChunk([&](EventChunk& chunk) { decodeChunk(chunk, events_offset, log.revision); });
 
-            if (event.is_statechange == CBTS_LOGSTART) {
-				log.log_start = event.time;
+        //Assign times and instance ids
+        for (const EventChunk& chunk : chunks) {
+            if (chunk.has_log_start) {
+                log.log_start = chunk.log_start;
+                log.server_start = chunk.server_start;
             }
-            else if (event.is_statechange == CBTS_LOGEND) {
-				log.log_end = event.time;
+            if (chunk.has_log_end) {
+                log.log_end = chunk.log_end;
             }
-
-            //Assign times and instance ids
-            if (agents.count(event.src_agent)) {
-                Agent& agent = agents.at(event.src_agent);
-                if (!agent.first_aware_set) {
-                    agent.first_aware = event.time;
-                    agent.first_aware_set = true;
+            for (size_t i = 0; i < agent_by_index.size(); ++i) {
+                const AgentAwareness& awareness = chunk.awareness[i];
+                Agent* agent = agent_by_index[i];
+                if (!agent || !awareness.seen) {
+                    continue;
                 }
-                agent.last_aware = event.time;
-                if (!event.is_statechange) {
-                    agent.instance_id = event.src_instid;
-                    agent_addrs.emplace(agent.instance_id, agent.addr);
+                if (!agent->first_aware_set) {
+                    agent->first_aware = awareness.first_aware;
+                    agent->first_aware_set = true;
+                }
+                agent->last_aware = awareness.last_aware;
+                if (awareness.has_instance) {
+                    agent->instance_id = awareness.instance_id;
                 }
             }
-
-            events.push_back(event);
         }
 
         //Copy times to players
@@ -229,143 +441,240 @@ namespace Revtc {
             player.second.last_aware = agent.last_aware;
         }
 
+        //Instance ids are reused over a log and agents can change theirs, so each id an agent took is held from
+        //its first event with the id (first_aware for the agent's first id) until the agent takes another one,
+        //or last_aware
+        instances.clear();
+        open_runs.assign(agent_by_index.size(), InstanceRun{});
+        for (const EventChunk& chunk : chunks) {
+            for (const InstanceRun& run : chunk.instance_runs) {
+                InstanceRun& open = open_runs[run.agent];
+                if (open.instid == run.instid) {
+                    continue; // the same id on both sides of a chunk edge
+                }
+                const Agent* agent = agent_by_index[run.agent];
+                if (open.instid) {
+                    instances.add(open.instid, open.time, run.time, agent->addr);
+                    open = run;
+                }
+                else {
+                    open = run;
+                    open.time = agent->first_aware;
+                }
+            }
+        }
+        for (size_t i = 0; i < open_runs.size(); ++i) {
+            if (open_runs[i].instid) {
+                const Agent* agent = agent_by_index[i];
+                instances.add(open_runs[i].instid, open_runs[i].time, agent->last_aware, agent->addr);
+            }
+        }
+        instances.build();
+
         // Second iteration
         //Map master instance ids to agents by addr
-        for (const auto& event : events) {
-            if (event.src_master_instid != 0) {
-                if (agent_addrs.count(event.src_master_instid) && agents.count(event.src_agent)) {
-                    Agent& slave = agents.at(event.src_agent);
-                    uint64_t master_addr = agent_addrs.at(event.src_master_instid);
-                    if (agents.count(master_addr)) {
-                        Agent& master = agents.at(master_addr);
-                        uint64_t time_rel = event.time;
-                        if (time_rel > master.first_aware && time_rel < master.last_aware) {
-                            slave.master_addr = master.addr;
-							if (players.count(master.addr)) {
-								Player& player = players.at(master.addr);
-								player.slaves.emplace(slave.addr);
-							}
-                        }
-                    }
+        forEachChunk([&](EventChunk& chunk) { mapMastersChunk(chunk); });
+        for (const EventChunk& chunk : chunks) {
+            for (size_t i = 0; i < agent_by_index.size(); ++i) {
+                if (chunk.masters[i] && agent_by_index[i]) {
+                    agent_by_index[i]->master_addr = chunk.masters[i];
+                }
+            }
+            for (const auto& slave_pair : chunk.slaves) {
+                std::vector<uint64_t>& slaves = players.at(slave_pair.first).slaves;
+                auto it = std::lower_bound(slaves.begin(), slaves.end(), slave_pair.second);
+                if (it == slaves.end() || *it != slave_pair.second) {
+                    slaves.insert(it, slave_pair.second);
                 }
             }
         }
 
-        // Third iteration - could parallelize this, seems plenty fast anyways
+        //Boon generation matrix, filled alongside the boon stacks below
+        log.generation.player_count = (uint16_t)players.size();
+        log.generation.boon_count = BuffRegistry::boonCount();
+        log.generation.ms.assign((size_t)log.generation.player_count * log.generation.player_count * log.generation.boon_count, 0);
+
+        // Third iteration
         //Extract data
-        for (const auto& event : events) {
-            Agent *src = nullptr;
-            Agent *dst = nullptr;
-            Agent *master = nullptr;
-            if (agents.count(event.src_agent)) {
-                src = &agents.at(event.src_agent);
+        dispatchMechanics(log.area_id, [&](auto mechanics) {
+            forEachChunk([&](EventChunk& chunk) { extractChunk<decltype(mechanics)>(chunk, log); });
+        });
+        for (const EventChunk& chunk : chunks) {
+            if (chunk.reward_at) {
+                log.reward_at = chunk.reward_at;
             }
-            if (agents.count(event.dst_agent)) {
-                dst = &agents.at(event.dst_agent);
-                dst->hits++;
+            if (chunk.boss_death) {
+                log.boss_death = chunk.boss_death;
             }
-
-            if (event.is_statechange) {
-                if (event.is_statechange == CBTS_REWARD) {
-                    log.reward_at = event.time;
-                }
-                else if (event.is_statechange == CBTS_CHANGEDEAD) {
-                    if (src && src->species_id == (uint16_t)log.area_id) {
-                        log.boss_death = event.time;
-                    }
+            for (size_t i = 0; i < agent_by_index.size(); ++i) {
+                const AgentTotals& totals = chunk.totals[i];
+                Agent* agent = agent_by_index[i];
+                if (!agent) {
+                    continue;
                 }
+                agent->direct_damage += totals.direct_damage;
+                agent->boss_direct_damage += totals.boss_direct_damage;
+                agent->condi_damage += totals.condi_damage;
+                agent->boss_condi_damage += totals.boss_condi_damage;
+                agent->hits += totals.hits;
+                agent->note_counter += totals.note_counter;
+                agent->defense += totals.defense;
             }
-            else if (event.is_activation) {
+            for (size_t i = 0; i < log.generation.ms.size(); ++i) {
+                log.generation.ms[i] += chunk.generation[i];
+            }
+        }
 
+        //Boon stacks of all tracks go into one flat array, grouped by track and in file order within a track
+        for (const EventChunk& chunk : chunks) {
+            for (const auto& stack_pair : chunk.stacks) {
+                buff_tracks[stack_pair.first].stacks_end++;
+            }
+        }
+        uint32_t stack_offset = 0;
+        for (Boon& boon : buff_tracks) {
+            boon.stacks_begin = stack_offset;
+            stack_offset += boon.stacks_end;
+            boon.stacks_end = boon.stacks_begin;
+        }
+        buff_stacks.resize(stack_offset, BoonStack(0, 0));
+        for (const EventChunk& chunk : chunks) {
+            for (const auto& stack_pair : chunk.stacks) {
+                buff_stacks[buff_tracks[stack_pair.first].stacks_end++] = stack_pair.second;
+            }
+        }
+
+        //Boss health, one timeline per boss agent in agent table order
+        std::vector<uint32_t> timeline_of(agent_by_index.size(), UINT32_MAX);
+        for (const EventChunk& chunk : chunks) {
+            for (const auto& health_pair : chunk.health) {
+                timeline_of[health_pair.first] = 0;
+            }
+            for (const auto& health_pair : chunk.max_health) {
+                timeline_of[health_pair.first] = 0;
+            }
+        }
+        for (size_t i = 0; i < agent_by_index.size(); ++i) {
+            if (timeline_of[i] != UINT32_MAX) {
+                timeline_of[i] = (uint32_t)log.boss_health.size();
+                log.boss_health.push_back(HealthTimeline{ agent_by_index[i]->addr, agent_by_index[i]->species_id, {}, {}, {} });
             }
-			else if (event.is_buffremove) {
-				if (src && src->agtype == AgentType::Player) {
-					Player& player = players.at(src->addr);
+        }
+        for (const EventChunk& chunk : chunks) {
+            for (const auto& health_pair : chunk.health) {
+                log.boss_health[timeline_of[health_pair.first]].points.push_back(health_pair.second);
+            }
+            for (const auto& health_pair : chunk.max_health) {
+                log.boss_health[timeline_of[health_pair.first]].max_health.push_back(health_pair.second);
+            }
+        }
+        for (HealthTimeline& timeline : log.boss_health) {
+            std::stable_sort(timeline.points.begin(), timeline.points.end(),
+                [](const HealthPoint& lhs, const HealthPoint& rhs) { return lhs.time < rhs.time; });
+            std::stable_sort(timeline.max_health.begin(), timeline.max_health.end(),
+                [](const MaxHealthPoint& lhs, const MaxHealthPoint& rhs) { return lhs.time < rhs.time; });
+            timeline.lowest.resize(timeline.points.size());
+            uint16_t lowest = 10000;
+            for (size_t i = 0; i < timeline.points.size(); ++i) {
+                lowest = std::min(lowest, timeline.points[i].percent);
+                timeline.lowest[i] = lowest;
+            }
+        }
 
-					BoonType type = skillidToBoonType(event.skillid);
+        //Incoming damage by skill, grouped by agent and sorted by skill id
+        size_t taken_count = 0;
+        for (const EventChunk& chunk : chunks) {
+            taken_count += chunk.taken.size();
+        }
+        std::vector<std::pair<uint64_t, SkillDamageTaken>> taken;
+        taken.reserve(taken_count);
+        for (const EventChunk& chunk : chunks) {
+            taken.insert(taken.end(), chunk.taken.begin(), chunk.taken.end());
+        }
+        std::sort(taken.begin(), taken.end(), [](const std::pair<uint64_t, SkillDamageTaken>& lhs,
+            const std::pair<uint64_t, SkillDamageTaken>& rhs) { return lhs.first < rhs.first; });
+        for (size_t i = 0; i < taken.size(); ++i) {
+            Agent* agent = agent_by_index[taken[i].first >> 32];
+            if (i > 0 && taken[i].first == taken[i - 1].first) {
+                SkillDamageTaken& skill = damage_taken.back();
+                skill.damage += taken[i].second.damage;
+                skill.barrier += taken[i].second.barrier;
+                skill.hits += taken[i].second.hits;
+                continue;
+            }
+            if (agent->taken_begin == agent->taken_end) {
+                agent->taken_begin = (uint32_t)damage_taken.size();
+            }
+            damage_taken.push_back(taken[i].second);
+            agent->taken_end = (uint32_t)damage_taken.size();
+        }
 
-					if (player.boons.count(type)) {
-						Boon& boon = player.boons.at(type);
-						if (event.is_buffremove == CBTB_ALL) {
-							BoonStack stack = BoonStack(event.time, 0, false, 0, true);
-							boon.stacks.push_back(stack);
-						}
-						else if (event.is_buffremove == CBTB_SINGLE) {
-							BoonStack stack = BoonStack(event.time, 0, false, event.buff_instid, true);
-							boon.stacks.push_back(stack);
-						}
-					}
-				}
+        //Casts left open at the end of a chunk are closed by the first end event of their agent in a later chunk
+        std::vector<Cast*> open_casts(agent_by_index.size(), nullptr);
+        for (EventChunk& chunk : chunks) {
+            for (const auto& end_pair : chunk.cast_ends) {
+                Cast* cast = open_casts[end_pair.first];
+                if (cast && cast->skill == end_pair.second.skill) {
+                    cast->duration = end_pair.second.start > cast->start ? end_pair.second.start - cast->start : 0;
+                    cast->outcome = end_pair.second.outcome;
+                }
+                open_casts[end_pair.first] = nullptr;
             }
-            else {
-                if (event.buff) { //Buff
-                    if (event.buff_dmg) {
-                        if (src) {
-                            src->condi_damage += event.buff_dmg;
-                            if (dst && log.boss_ids.count(dst->species_id)) {
-                                src->boss_condi_damage += event.buff_dmg;
-                            }
-                        }
-                    }
-                    else if (event.value) { //Buff Application
-						Agent *destination = nullptr;
-
-						//Boon extension events have no dst
-						if (src != dst) {
-							destination = dst;
-						}
-						else {
-							destination = src;
-						}
-
-                        if (destination && destination->agtype == AgentType::Player) {
-                            Player& player = players.at(destination->addr);
-							BoonType type = skillidToBoonType(event.skillid);
-
-							if (player.boons.count(type)) {
-								Boon& boon = player.boons.at(type);
-								BoonStack stack = BoonStack(event.time, event.value,
-									event.is_offcycle, event.buff_instid);
-								boon.stacks.push_back(stack);
-							}
-                        }
-                    }
+            for (size_t i = 0; i < agent_by_index.size(); ++i) {
+                uint32_t open = chunk.cast_open[i];
+                if (open != CAST_NONE) {
+                    open_casts[i] = open == CAST_CLOSED ? nullptr : &chunk.casts[open].second;
                 }
-                else { //Physical
-                    if (src) {
-                        src->direct_damage += event.value;
-                        if (dst) {
-                            if (log.boss_ids.count(dst->species_id)) {
-                                src->boss_direct_damage += event.value;
-                            }
+            }
+        }
 
-							//Low-tech orb pusher detect on Keep Construct
-                            else if (log.area_id == BossID::KEEP_CONSTRUCT && dst->species_id == KC_CONSTRUCT_CORE) {
-                                src->note_counter++;
-                            }
-                        }
-                    }
-                    else if (src && dst) {
-                        if (log.area_id == BossID::DEIMOS && src->species_id == DEIMOS_HANDS) {
-                            src->note_counter++;
-                        }
-                    }
-                }
+        //Casts of all agents go into one flat array, grouped by agent like the boon stacks
+        for (const EventChunk& chunk : chunks) {
+            for (const auto& cast_pair : chunk.casts) {
+                agent_by_index[cast_pair.first]->casts_end++;
+            }
+        }
+        uint32_t cast_offset = 0;
+        for (Agent* agent : agent_by_index) {
+            if (!agent) {
+                continue;
+            }
+            agent->casts_begin = cast_offset;
+            cast_offset += agent->casts_end;
+            agent->casts_end = agent->casts_begin;
+        }
+        casts.resize(cast_offset);
+        for (const EventChunk& chunk : chunks) {
+            for (const auto& cast_pair : chunk.casts) {
+                casts[agent_by_index[cast_pair.first]->casts_end++] = cast_pair.second;
+            }
+        }
+        for (Agent* agent : agent_by_index) {
+            //Event order is only nearly time order
+            if (agent && !std::is_sorted(casts.begin() + agent->casts_begin, casts.begin() + agent->casts_end,
+                [](const Cast& lhs, const Cast& rhs) { return lhs.start < rhs.start; })) {
+                std::stable_sort(casts.begin() + agent->casts_begin, casts.begin() + agent->casts_end,
+                    [](const Cast& lhs, const Cast& rhs) { return lhs.start < rhs.start; });
             }
         }
 
-        const Agent& boss = agents.at(boss_addr);
-        log.boss_lifetime = boss.last_aware - boss.first_aware;
+        const Agent* boss = has_boss ? &agents.at(boss_addr) : nullptr;
+        log.boss_lifetime = boss ? boss->last_aware - boss->first_aware : 0;
 
-        std::string tracked_player_name;
+        uint64_t tracked_player_addr = 0;
         uint32_t tracked_count = 0;
 
         // Choose a time to set as the encounter end. This can have a significant effect on all the stats.
-		// For now, prefer the reward > boss death > boss lifetime.
+		// For now, prefer the reward > boss death > boss lifetime. Without a boss the log end, or the last event.
         uint64_t encounter_end =  log.reward_at ? log.reward_at : log.boss_death ? log.boss_death : log.boss_lifetime;
+        if (!boss) {
+            encounter_end = log.log_end ? log.log_end : events.empty() ? log.log_start : events.back().time;
+            encounter_end = std::max(encounter_end, log.log_start);
+        }
 		uint64_t encounter_duration = encounter_end - log.log_start;
         float encounter_duration_secs = (float) encounter_duration / 1000.f;
         log.encounter_duration = encounter_duration / 1000u;
+        log.encounter_duration_ms = encounter_duration;
 
         for (auto& player_pair : players) {
             auto& player = player_pair.second;
@@ -376,6 +685,7 @@ namespace Revtc {
 				player.condi_damage = agent.condi_damage;
 				player.boss_physical_damage = agent.boss_direct_damage;
 				player.boss_condi_damage = agent.boss_condi_damage;
+				player.note_counter = agent.note_counter;
 			}
 			for (uint64_t slave_addr : player.slaves)
 			{
@@ -387,111 +697,947 @@ namespace Revtc {
 					player.boss_condi_damage += slave.boss_condi_damage;
 				}
 			}
-            player.dps = (uint32_t) roundf((float)(player.physical_damage + player.condi_damage) / encounter_duration_secs);
-            player.boss_dps = (uint32_t) roundf((float)(player.boss_physical_damage + player.boss_condi_damage) / encounter_duration_secs);
+            if (encounter_duration_secs > 0) {
+                player.dps = (uint32_t) roundf((float)(player.physical_damage + player.condi_damage) / encounter_duration_secs);
+                player.boss_dps = (uint32_t) roundf((float)(player.boss_physical_damage + player.boss_condi_damage) / encounter_duration_secs);
+            }
+            else {
+                player.dps = 0;
+                player.boss_dps = 0;
+            }
 
             //Notes
-            if (log.area_id == BossID::KEEP_CONSTRUCT || log.area_id == BossID::DEIMOS) {
-                if (player.note_counter > tracked_count) {
-                    tracked_player_name = player.name;
-                    tracked_count = player.note_counter;
-                }
+            if (note_label && player.note_counter > tracked_count) {
+                tracked_player_addr = player.addr;
+                tracked_count = player.note_counter;
             }
         }
 
 		replay_boons(log.log_start, encounter_duration);
 
+        //Copy assignment into the existing entries reuses their strings and vectors
+        log.players.resize(players.size());
+        size_t player_index = 0;
         for (auto& player_pair : players) {
             auto& player = player_pair.second;
 
             //Notes
-            if (log.area_id == BossID::KEEP_CONSTRUCT) {
-                if (player.name == tracked_player_name) {
-                    player.note = "Orb Pusher";
-                }
-            }
-            else if (log.area_id == BossID::DEIMOS) {
-                if (player.name == tracked_player_name) {
-                    player.note = "Hand Kiter";
-                }
+            if (note_label && player.addr == tracked_player_addr) {
+                player.note = note_label;
             }
 
-			for (const auto& boon_pair : player.boons) {
-				switch (boon_pair.first) {
-					case BoonType::MIGHT:
-						player.might_avg = boon_pair.second.average;
-						break;
-					case BoonType::QUICKNESS:
-						player.quickness_avg = boon_pair.second.average;
-						break;
-					case BoonType::ALACRITY:
-						player.alacrity_avg = boon_pair.second.average;
-						break;
-					case BoonType::FURY:
-						player.fury_avg = boon_pair.second.average;
-						break;
-					default:
-						break;
-				}
+			const Agent& agent = agents.at(player.addr);
+			player.buffs.resize(buff_count);
+			for (uint16_t i = 0; i < buff_count; ++i) {
+				player.buffs[i] = buff_tracks[(size_t)agent.buff_slot * buff_count + i].average;
 			}
+			player.might_avg = player.buffs[BuffRegistry::index((uint32_t)BoonType::MIGHT)];
+			player.quickness_avg = player.buffs[BuffRegistry::index((uint32_t)BoonType::QUICKNESS)];
+			player.alacrity_avg = player.buffs[BuffRegistry::index((uint32_t)BoonType::ALACRITY)];
+			player.fury_avg = player.buffs[BuffRegistry::index((uint32_t)BoonType::FURY)];
+			player.casts.assign(casts.begin() + agent.casts_begin, casts.begin() + agent.casts_end);
+			player.defense = agent.defense;
+			player.damage_taken.assign(damage_taken.begin() + agent.taken_begin, damage_taken.begin() + agent.taken_end);
 
-            log.players.push_back(player);
+            log.players[player_index++] = player;
         }
         std::sort(log.players.begin(), log.players.end(), std::less<Player>());
 
+        if (boss && boss->buff_slot != BUFF_NONE) {
+            log.boss_buffs.resize(buff_count);
+            for (uint16_t i = 0; i < buff_count; ++i) {
+                log.boss_buffs[i] = buff_tracks[(size_t)boss->buff_slot * buff_count + i].average;
+            }
+        }
+
         log.valid = true;
-        return log;
     }
 
 	void Parser::replay_boons(uint64_t log_start, uint64_t encounter_duration)
 	{
-		for (auto& player_pair : players) {
-			Player& player = player_pair.second;
-			for (auto& boon_pair : player.boons) {
-				Boon& boon = boon_pair.second;
-				size_t track_index = 0;
-				uint64_t stacks_total = 0;
-				for (uint64_t time = log_start; time < log_start + encounter_duration - 50; ++time) {
-					while (track_index < boon.stacks.size()) {
-						BoonStack& stack = boon.stacks[track_index];
-						if (stack.start_time == time) {
-							if (stack.is_clear) {
-								if (stack.buff_instid) {
-									int i = 0;
-									while (i != boon.replay.size()) {
-										BoonStack &existing_stack = boon.replay[i];
-										if (existing_stack.buff_instid == stack.buff_instid) {
-											boon.replay.erase(boon.replay.begin() + i);
-											break;
-										}
-										++i;
-									}
-								}
-								else {
-									boon.replay.clear();
-								}
-							}
-							else if (!stack.is_offcycle) {
-								boon.replay.push_back(stack);
-							}
-							++track_index;
-							continue;
-						}
-						break;
-					}
+		//Tracks are independent, so they are split across the worker threads
+		size_t worker_count = std::max<size_t>(1, std::min<size_t>(threads, buff_tracks.size() / 64));
+		auto replay_range = [&](size_t worker, BoonStackSet& active) {
+			size_t begin = buff_tracks.size() * worker / worker_count;
+			size_t end = buff_tracks.size() * (worker + 1) / worker_count;
+			for (size_t i = begin; i < end; ++i) {
+				replayTrack(buff_tracks[i], active, log_start, encounter_duration);
+			}
+		};
 
-					if (boon.intensity) {
-						stacks_total += boon.replay.size();
-					}
-					else if (boon.replay.size()) {
-						++stacks_total;
+		while (worker_stacks.size() + 1 < worker_count) {
+			worker_stacks.emplace_back(memoryCounter(MemoryPool::REPLAY));
+		}
+		std::vector<std::thread> workers;
+		for (size_t worker = 1; worker < worker_count; ++worker) {
+			workers.emplace_back([&, worker] { replay_range(worker, worker_stacks[worker - 1]); });
+		}
+		replay_range(0, active_stacks);
+		for (std::thread& worker : workers) {
+			worker.join();
+		}
+	}
+
+	void Parser::replayTrack(Boon& boon, BoonStackSet& active, uint64_t log_start, uint64_t encounter_duration)
+	{
+		const uint64_t window_end = log_start + encounter_duration - 50;
+		const BuffDef& def = BuffRegistry::at(boon.index);
+		active.reset(def.stacking);
+
+		//Integrate the active stack count between stack events and expiries instead of stepping every millisecond
+		uint64_t stacks_total = 0;
+		uint64_t time = log_start;
+		auto advance = [&](uint64_t until) {
+			for (uint64_t expiry = active.nextExpiry(); expiry <= until; expiry = active.nextExpiry()) {
+				if (expiry > time) {
+					stacks_total += activeStacks(active, def) * (expiry - time);
+					time = expiry;
+				}
+				active.expire(expiry);
+			}
+			if (until > time) {
+				stacks_total += activeStacks(active, def) * (until - time);
+				time = until;
+			}
+		};
+
+		for (uint32_t i = boon.stacks_begin; i < boon.stacks_end; ++i) {
+			const BoonStack& stack = buff_stacks[i];
+			if (stack.start_time >= window_end) {
+				break;
+			}
+			advance(stack.start_time);
+
+			if (stack.is_clear) {
+				if (stack.buff_instid) {
+					active.remove(stack.buff_instid, stack.start_time);
+				}
+				else {
+					active.clear();
+				}
+			}
+			else if (stack.is_offcycle) {
+				active.extend(stack.buff_instid, stack.duration, stack.start_time);
+			}
+			else {
+				active.insert(stack, def.max_stacks);
+			}
+		}
+		advance(window_end);
+		boon.average = (float) stacks_total / (float) encounter_duration;
+	}
+
+	uint64_t Parser::activeStacks(const BoonStackSet& active, const BuffDef& def)
+	{
+		if (def.stacking == BuffStacking::INTENSITY) {
+			return active.size();
+		}
+		return active.size() ? 1 : 0;
+	}
+
+	BoonStackSet::BoonStackSet(MemoryCounter* counter)
+		: stacks(counter)
+		, keys(counter)
+		, table(counter)
+		, heap(counter)
+		, longest(counter)
+		, shortest(counter)
+		, next_private_key(1ull << 32)
+		, stacking(BuffStacking::INTENSITY)
+		, ticking(0)
+	{
+	}
+
+	void BoonStackSet::reset(BuffStacking stacking)
+	{
+		clear();
+		this->stacking = stacking;
+	}
+
+	void BoonStackSet::clear()
+	{
+		for (uint64_t key : keys) {
+			unput(key);
+		}
+		stacks.clear();
+		keys.clear();
+		heap.clear();
+		longest.clear();
+		shortest.clear();
+		ticking = 0;
+	}
+
+	void BoonStackSet::insert(const BoonStack& stack, uint16_t max_stacks)
+	{
+		const uint64_t time = stack.start_time;
+		uint64_t key = stack.buff_instid ? stack.buff_instid : next_private_key++;
+		if (uint32_t* position = find(key)) {
+			erase(*position);
+		}
+
+		//Over capacity the stack that runs out first is dropped, unless the new one would run out before it
+		if (max_stacks && stacks.size() >= max_stacks) {
+			uint64_t remaining;
+			uint64_t first = firstOut(time, remaining);
+			if (stack.duration <= remaining) {
+				promote(time);
+				return;
+			}
+			erase(*find(first));
+		}
+
+		put(key, (uint32_t)stacks.size());
+		stacks.push_back(stack);
+		keys.push_back(key);
+		if (stacking == BuffStacking::INTENSITY) {
+			tick(key, time);
+		}
+		else {
+			wait(key);
+			promote(time);
+		}
+	}
+
+	bool BoonStackSet::remove(uint32_t buff_instid, uint64_t time)
+	{
+		uint32_t* position = buff_instid ? find(buff_instid) : nullptr;
+		if (!position) {
+			return false;
+		}
+		erase(*position);
+		promote(time);
+		return true;
+	}
+
+	bool BoonStackSet::extend(uint32_t buff_instid, uint64_t duration, uint64_t time)
+	{
+		uint32_t* position = buff_instid ? find(buff_instid) : nullptr;
+		if (!position) {
+			return false;
+		}
+		BoonStack& stack = stacks[*position];
+		stack.duration += duration;
+		//The old heap entries go stale and are skipped once they surface
+		if (stacking == BuffStacking::INTENSITY || buff_instid == ticking) {
+			heap.push_back(Expiry{ stack.start_time + stack.duration, buff_instid });
+			std::push_heap(heap.begin(), heap.end(), std::greater<Expiry>());
+		}
+		else {
+			wait(buff_instid);
+			promote(time);
+		}
+		return true;
+	}
+
+	uint64_t BoonStackSet::nextExpiry()
+	{
+		while (!heap.empty()) {
+			const Expiry& top = heap.front();
+			uint32_t* position = find(top.key);
+			if (position && stacks[*position].start_time + stacks[*position].duration == top.end_time
+				&& (stacking == BuffStacking::INTENSITY || top.key == ticking)) {
+				return top.end_time;
+			}
+			std::pop_heap(heap.begin(), heap.end(), std::greater<Expiry>());
+			heap.pop_back();
+		}
+		return UINT64_MAX;
+	}
+
+	void BoonStackSet::expire(uint64_t time)
+	{
+		for (uint64_t end = nextExpiry(); end <= time; end = nextExpiry()) {
+			erase(*find(heap.front().key));
+			std::pop_heap(heap.begin(), heap.end(), std::greater<Expiry>());
+			heap.pop_back();
+			promote(end);
+		}
+	}
+
+	//Starts the stack running at time
+	void BoonStackSet::tick(uint64_t key, uint64_t time)
+	{
+		BoonStack& stack = stacks[*find(key)];
+		stack.start_time = time;
+		if (stacking == BuffStacking::DURATION) {
+			ticking = key;
+		}
+		heap.push_back(Expiry{ time + stack.duration, key });
+		std::push_heap(heap.begin(), heap.end(), std::greater<Expiry>());
+	}
+
+	//Queues a duration stack with the remaining time held in its duration
+	void BoonStackSet::wait(uint64_t key)
+	{
+		const Waiting entry{ stacks[*find(key)].duration, key };
+		longest.push_back(entry);
+		std::push_heap(longest.begin(), longest.end());
+		shortest.push_back(entry);
+		std::push_heap(shortest.begin(), shortest.end(), std::greater<Waiting>());
+	}
+
+	bool BoonStackSet::current(const Waiting& entry)
+	{
+		uint32_t* position = find(entry.key);
+		return position && entry.key != ticking && stacks[*position].duration == entry.remaining;
+	}
+
+	//Lets the longest duration stack tick, pausing the ticking one if a waiting stack has more time left
+	void BoonStackSet::promote(uint64_t time)
+	{
+		if (stacking != BuffStacking::DURATION) {
+			return;
+		}
+		while (!longest.empty() && !current(longest.front())) {
+			std::pop_heap(longest.begin(), longest.end());
+			longest.pop_back();
+		}
+		if (longest.empty()) {
+			return;
+		}
+		const uint64_t next = longest.front().key;
+		if (ticking) {
+			BoonStack& running = stacks[*find(ticking)];
+			const uint64_t end = running.start_time + running.duration;
+			const uint64_t remaining = end > time ? end - time : 0;
+			if (longest.front().remaining <= remaining) {
+				return;
+			}
+			running.start_time = time;
+			running.duration = remaining;
+			const uint64_t paused = ticking;
+			ticking = 0;
+			std::pop_heap(longest.begin(), longest.end());
+			longest.pop_back();
+			wait(paused);
+		}
+		else {
+			std::pop_heap(longest.begin(), longest.end());
+			longest.pop_back();
+		}
+		tick(next, time);
+	}
+
+	//Key of the stack that runs out first and its remaining time, the set must not be empty
+	uint64_t BoonStackSet::firstOut(uint64_t time, uint64_t& remaining)
+	{
+		uint64_t first = 0;
+		remaining = UINT64_MAX;
+		uint64_t end = nextExpiry();
+		if (end != UINT64_MAX) {
+			first = heap.front().key;
+			remaining = end > time ? end - time : 0;
+		}
+		if (stacking == BuffStacking::DURATION) {
+			while (!shortest.empty() && !current(shortest.front())) {
+				std::pop_heap(shortest.begin(), shortest.end(), std::greater<Waiting>());
+				shortest.pop_back();
+			}
+			if (!shortest.empty() && shortest.front().remaining < remaining) {
+				first = shortest.front().key;
+				remaining = shortest.front().remaining;
+			}
+		}
+		return first;
+	}
+
+	void BoonStackSet::erase(uint32_t position)
+	{
+		if (keys[position] == ticking) {
+			ticking = 0;
+		}
+		unput(keys[position]);
+		uint32_t last = (uint32_t)stacks.size() - 1;
+		if (position != last) {
+			stacks[position] = stacks[last];
+			keys[position] = keys[last];
+			*find(keys[position]) = position;
+		}
+		stacks.pop_back();
+		keys.pop_back();
+	}
+
+	size_t BoonStackSet::slotOf(uint64_t key) const
+	{
+		return (size_t)((key * 0x9E3779B97F4A7C15ull) >> 32) & (table.size() - 1);
+	}
+
+	uint32_t* BoonStackSet::find(uint64_t key)
+	{
+		if (table.empty()) {
+			return nullptr;
+		}
+		for (size_t slot = slotOf(key); table[slot].key; slot = (slot + 1) & (table.size() - 1)) {
+			if (table[slot].key == key) {
+				return &table[slot].position;
+			}
+		}
+		return nullptr;
+	}
+
+	void BoonStackSet::put(uint64_t key, uint32_t position)
+	{
+		//Keep the load factor at or below one half
+		if ((keys.size() + 1) * 2 > table.size()) {
+			TrackedVector<Slot> old(table.get_allocator());
+			old.swap(table);
+			table.assign(std::max<size_t>(16, old.size() * 2), Slot{ 0, 0 });
+			for (const Slot& entry : old) {
+				if (entry.key) {
+					size_t slot = slotOf(entry.key);
+					while (table[slot].key) {
+						slot = (slot + 1) & (table.size() - 1);
 					}
+					table[slot] = entry;
 				}
-				boon.average = (float) stacks_total / (float) encounter_duration;
 			}
 		}
+		size_t slot = slotOf(key);
+		while (table[slot].key && table[slot].key != key) {
+			slot = (slot + 1) & (table.size() - 1);
+		}
+		table[slot] = Slot{ key, position };
 	}
 
+	void BoonStackSet::unput(uint64_t key)
+	{
+		if (table.empty()) {
+			return;
+		}
+		const size_t mask = table.size() - 1;
+		size_t slot = slotOf(key);
+		while (table[slot].key != key) {
+			if (!table[slot].key) {
+				return;
+			}
+			slot = (slot + 1) & mask;
+		}
+		//Backward shift deletion keeps probe chains intact without tombstones
+		size_t hole = slot;
+		for (size_t next = (hole + 1) & mask; table[next].key; next = (next + 1) & mask) {
+			size_t home = slotOf(table[next].key);
+			if (((next - home) & mask) >= ((next - hole) & mask)) {
+				table[hole] = table[next];
+				hole = next;
+			}
+		}
+		table[hole] = Slot{ 0, 0 };
+	}
+
+    template<typename Fn>
+    void Parser::forEachChunk(Fn&& fn)
+    {
+        std::vector<std::thread> workers;
+        for (size_t i = 1; i < chunks.size(); ++i) {
+            workers.emplace_back([&, i] { fn(chunks[i]); });
+        }
+        fn(chunks[0]);
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+    }
+
+    void Parser::decodeEvent(const unsigned char* record, uint8_t revision, CombatEvent& event)
+    {
+        if (revision == 0) {
+            CombatEventRev0 event_rev;
+            memcpy(&event_rev, record, sizeof(event_rev));
+
+            event.time = event_rev.time;
+            event.src_agent = event_rev.src_agent;
+            event.dst_agent = event_rev.dst_agent;
+            event.value = event_rev.value;
+            event.buff_dmg = event_rev.buff_dmg;
+            event.overstack_value = event_rev.overstack_value;
+            event.skillid = event_rev.skillid;
+            event.src_instid = event_rev.src_instid;
+            event.dst_instid = event_rev.dst_instid;
+            event.src_master_instid = event_rev.src_master_instid;
+            event.dst_master_instid = 0;
+            event.iff = event_rev.iff;
+            event.buff = event_rev.buff;
+            event.result = event_rev.result;
+            event.is_activation = event_rev.is_activation;
+            event.is_buffremove = event_rev.is_buffremove;
+            event.is_ninety = event_rev.is_ninety;
+            event.is_fifty = event_rev.is_fifty;
+            event.is_moving = event_rev.is_moving;
+            event.is_statechange = event_rev.is_statechange;
+            event.is_flanking = event_rev.is_flanking;
+            event.is_shields = event_rev.is_shields;
+            event.is_offcycle = event_rev.is_offcycle;
+            event.buff_instid = 0;
+        }
+        else {
+            memcpy(&event, record, sizeof(event));
+        }
+    }
+
+    void Parser::decodeChunk(EventChunk& chunk, size_t events_offset, uint8_t revision)
+    {
+        chunk.has_log_start = false;
+        chunk.has_log_end = false;
+        chunk.awareness.assign(agent_by_index.size(), AgentAwareness{});
+        chunk.instance_runs.clear();
+
+        for (size_t i = chunk.begin; i < chunk.end; ++i) {
+            CombatEvent& event = events[i];
+            decodeEvent(&buf[events_offset + i * (revision == 0 ? sizeof(CombatEventRev0) : sizeof(CombatEvent))], revision, event);
+
+            if (event.is_statechange == CBTS_LOGSTART) {
+                chunk.log_start = event.time;
+                chunk.server_start = (uint32_t)event.value;
+                chunk.has_log_start = true;
+            }
+            else if (event.is_statechange == CBTS_LOGEND) {
+                chunk.log_end = event.time;
+                chunk.has_log_end = true;
+            }
+
+            auto src_it = agents.find(event.src_agent);
+            if (src_it != agents.end()) {
+                AgentAwareness& awareness = chunk.awareness[src_it->second.index];
+                if (!awareness.seen) {
+                    awareness.first_aware = event.time;
+                    awareness.seen = true;
+                }
+                awareness.last_aware = event.time;
+                if (!event.is_statechange) {
+                    awareness.instance_id = event.src_instid;
+                    awareness.has_instance = true;
+                    if (event.src_instid && event.src_instid != awareness.run_instid) {
+                        awareness.run_instid = event.src_instid;
+                        chunk.instance_runs.push_back(InstanceRun{ src_it->second.index, event.src_instid, event.time });
+                    }
+                }
+            }
+        }
+    }
+
+    void Parser::mapMastersChunk(EventChunk& chunk)
+    {
+        chunk.masters.assign(agent_by_index.size(), 0);
+        chunk.slaves.clear();
+
+        for (size_t i = chunk.begin; i < chunk.end; ++i) {
+            const CombatEvent& event = events[i];
+            if (event.src_master_instid != 0) {
+                uint64_t master_addr = instances.find(event.src_master_instid, event.time);
+                if (!master_addr) {
+                    continue;
+                }
+                auto slave_it = agents.find(event.src_agent);
+                if (slave_it == agents.end() || chunk.masters[slave_it->second.index] == master_addr) {
+                    continue;
+                }
+                chunk.masters[slave_it->second.index] = master_addr;
+                if (players.count(master_addr)) {
+                    chunk.slaves.emplace_back(master_addr, slave_it->first);
+                }
+            }
+        }
+    }
+
+    template<typename Encounter>
+    void Parser::extractChunk(EventChunk& chunk, const Log& log)
+    {
+        const uint16_t buff_count = BuffRegistry::count();
+        chunk.reward_at = 0;
+        chunk.boss_death = 0;
+        chunk.health.clear();
+        chunk.max_health.clear();
+        //Only the cells used by the last chunk need resetting while the table keeps its shape
+        const size_t skill_count = skill_ids.size();
+        const size_t taken_table = (size_t)log.generation.player_count * skill_count;
+        if (chunk.taken_positions.size() == taken_table) {
+            for (uint32_t cell : chunk.taken_cells) {
+                chunk.taken_positions[cell] = TAKEN_NONE;
+            }
+        }
+        else {
+            chunk.taken_positions.assign(taken_table, (uint32_t)TAKEN_NONE);
+        }
+        chunk.taken_cells.clear();
+        chunk.unlisted_positions.clear();
+        chunk.taken.clear();
+
+        //Incoming damage on dst, broken down by skill for players
+        auto take = [&](const Agent& dst, const CombatEvent& event, uint32_t damage) {
+            DefenseStats& defense = chunk.totals[dst.index].defense;
+            uint32_t barrier = event.is_shields ? event.overstack_value : 0;
+            defense.damage_taken += damage;
+            defense.barrier_absorbed += barrier;
+            if (dst.agtype != AgentType::Player) {
+                return;
+            }
+            uint64_t key = (uint64_t)dst.index << 32 | event.skillid;
+            uint32_t* position;
+            auto skill_it = skills.find((int32_t)event.skillid);
+            if (skill_it != skills.end()) {
+                uint32_t cell = (uint32_t)(dst.buff_slot * skill_count + skill_it->second.index);
+                position = &chunk.taken_positions[cell];
+                if (*position == TAKEN_NONE) {
+                    chunk.taken_cells.push_back(cell);
+                }
+            }
+            else {
+                position = &chunk.unlisted_positions.try_emplace(key, (uint32_t)TAKEN_NONE).first->second;
+            }
+            if (*position == TAKEN_NONE) {
+                *position = (uint32_t)chunk.taken.size();
+                chunk.taken.emplace_back(key, SkillDamageTaken{ event.skillid, 0, 0, 0 });
+            }
+            SkillDamageTaken& skill = chunk.taken[*position].second;
+            skill.damage += damage;
+            skill.barrier += barrier;
+            skill.hits++;
+        };
+        chunk.totals.assign(agent_by_index.size(), AgentTotals{});
+        chunk.stacks.clear();
+        chunk.generation.assign(log.generation.ms.size(), 0);
+        chunk.casts.clear();
+        chunk.cast_open.assign(agent_by_index.size(), (uint32_t)CAST_NONE);
+        chunk.cast_ends.clear();
+        const BoonGeneration generation_shape = BoonGeneration{ log.generation.player_count, log.generation.boon_count, {} };
+
+        for (size_t i = chunk.begin; i < chunk.end; ++i) {
+            const CombatEvent& event = events[i];
+            Agent *src = nullptr;
+            Agent *dst = nullptr;
+            auto src_it = agents.find(event.src_agent);
+            if (src_it != agents.end()) {
+                src = &src_it->second;
+            }
+            auto dst_it = agents.find(event.dst_agent);
+            if (dst_it != agents.end()) {
+                dst = &dst_it->second;
+                chunk.totals[dst->index].hits++;
+            }
+
+            if (event.is_statechange) {
+                if (event.is_statechange == CBTS_REWARD) {
+                    chunk.reward_at = event.time;
+                }
+                else if (event.is_statechange == CBTS_CHANGEDEAD) {
+                    if (src) {
+                        chunk.totals[src->index].defense.deaths++;
+                        if (src->species_id == (uint16_t)log.area_id) {
+                            chunk.boss_death = event.time;
+                        }
+                    }
+                }
+                else if (event.is_statechange == CBTS_CHANGEDOWN) {
+                    if (src) {
+                        chunk.totals[src->index].defense.downs++;
+                    }
+                }
+                else if (event.is_statechange == CBTS_HEALTHUPDATE || event.is_statechange == CBTS_MAXHEALTHUPDATE) {
+                    if (src && src->agtype != AgentType::Player && log.boss_ids.count(src->species_id)) {
+                        uint32_t time = event.time > log.log_start ? (uint32_t)(event.time - log.log_start) : 0;
+                        if (event.is_statechange == CBTS_HEALTHUPDATE) {
+                            chunk.health.emplace_back(src->index, HealthPoint{ time, (uint16_t)std::min<uint64_t>(event.dst_agent, 10000) });
+                        }
+                        else {
+                            chunk.max_health.emplace_back(src->index, MaxHealthPoint{ time, event.dst_agent });
+                        }
+                    }
+                }
+            }
+            else if (event.is_activation) {
+                //Starts open a cast on their agent, the next end event closes it. An end with no start
+                //earlier in the chunk is kept for the merge, which pairs it with a cast left open by an
+                //earlier chunk.
+                if (src) {
+                    uint32_t& open = chunk.cast_open[src->index];
+                    uint32_t time = event.time > log.log_start ? (uint32_t)(event.time - log.log_start) : 0;
+                    auto skill_it = skills.find((int32_t)event.skillid);
+                    uint16_t skill = skill_it != skills.end() && skill_it->second.index < CAST_SKILL_UNKNOWN
+                        ? (uint16_t)skill_it->second.index : CAST_SKILL_UNKNOWN;
+
+                    CastOutcome outcome = CastOutcome::UNFINISHED;
+                    switch (event.is_activation) {
+                        case ACTV_NORMAL:
+                        case ACTV_QUICKNESS:
+                            //A cast still open here never got its end event and stays unfinished
+                            open = (uint32_t)chunk.casts.size();
+                            chunk.casts.emplace_back(src->index, Cast{ time, 0, skill, CastOutcome::UNFINISHED,
+                                event.is_activation == ACTV_QUICKNESS });
+                            break;
+                        case ACTV_CANCEL_FIRE: outcome = CastOutcome::FIRED; break;
+                        case ACTV_CANCEL_CANCEL: outcome = CastOutcome::CANCELLED; break;
+                        case ACTV_RESET: outcome = CastOutcome::COMPLETED; break;
+                    }
+
+                    if (outcome != CastOutcome::UNFINISHED) {
+                        if (open == CAST_NONE) {
+                            chunk.cast_ends.emplace_back(src->index, Cast{ time, 0, skill, outcome, false });
+                        }
+                        else if (open != CAST_CLOSED) {
+                            Cast& cast = chunk.casts[open].second;
+                            if (cast.skill == skill) {
+                                cast.duration = time > cast.start ? time - cast.start : 0;
+                                cast.outcome = outcome;
+                            }
+                        }
+                        open = CAST_CLOSED;
+                    }
+                }
+            }
+            else if (event.is_buffremove) {
+                uint16_t buff_index = BuffRegistry::index(event.skillid);
+                if (src && src->buff_slot != BUFF_NONE && buff_index != BUFF_NONE) {
+                    uint32_t track = (uint32_t)src->buff_slot * buff_count + buff_index;
+                    if (event.is_buffremove == CBTB_ALL) {
+                        chunk.stacks.emplace_back(track, BoonStack(event.time, 0, false, 0, true));
+                    }
+                    else if (event.is_buffremove == CBTB_SINGLE) {
+                        chunk.stacks.emplace_back(track, BoonStack(event.time, 0, false, event.buff_instid, true));
+                    }
+                }
+            }
+            else {
+                if (event.buff) { //Buff
+                    if (event.buff_dmg) {
+                        if (src) {
+                            chunk.totals[src->index].condi_damage += event.buff_dmg;
+                            if (dst && log.boss_ids.count(dst->species_id)) {
+                                chunk.totals[src->index].boss_condi_damage += event.buff_dmg;
+                            }
+                        }
+                        if (dst && event.buff_dmg > 0) {
+                            take(*dst, event, (uint32_t)event.buff_dmg);
+                        }
+                    }
+                    else if (event.value) { //Buff Application
+                        //Extensions (is_offcycle) target the extended agent like any other application
+                        Agent *destination = dst;
+
+                        uint16_t buff_index = BuffRegistry::index(event.skillid);
+                        if (destination && destination->buff_slot != BUFF_NONE && buff_index != BUFF_NONE) {
+                            uint32_t track = (uint32_t)destination->buff_slot * buff_count + buff_index;
+                            chunk.stacks.emplace_back(track, BoonStack(event.time, event.value,
+                                event.is_offcycle, event.buff_instid));
+
+                            //Credit the applying player, or the master of an applying minion
+                            const Agent* source = src;
+                            if (source && source->agtype != AgentType::Player && players.count(source->master_addr)) {
+                                source = &agents.find(source->master_addr)->second;
+                            }
+                            if (destination->agtype == AgentType::Player && source && source->agtype == AgentType::Player
+                                && buff_index < generation_shape.boon_count) {
+                                size_t cell = ((size_t)source->buff_slot * generation_shape.player_count + destination->buff_slot)
+                                    * generation_shape.boon_count + buff_index;
+                                chunk.generation[cell] += BoonGeneration::contributed(event);
+                            }
+                        }
+                    }
+                }
+                else { //Physical
+                    if (src) {
+                        chunk.totals[src->index].direct_damage += event.value;
+                        if (dst && log.boss_ids.count(dst->species_id)) {
+                            chunk.totals[src->index].boss_direct_damage += event.value;
+                        }
+                        if (const Agent* noted = Encounter::physical(event, *src, dst)) {
+                            chunk.totals[noted->index].note_counter++;
+                        }
+                    }
+                    if (dst) {
+                        DefenseStats& defense = chunk.totals[dst->index].defense;
+                        switch (event.result) {
+                            case CBTR_BLOCK: defense.blocked++; break;
+                            case CBTR_EVADE: defense.evaded++; break;
+                            case CBTR_ABSORB: defense.invulned++; break;
+                            case CBTR_BLIND: defense.missed++; break;
+                        }
+                        if (event.value > 0) {
+                            take(*dst, event, (uint32_t)event.value);
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    uint32_t HealthTimeline::timeAt(uint16_t percent) const
+    {
+        //lowest is non-increasing, so the first entry at or below percent is found by binary search
+        auto it = std::partition_point(lowest.begin(), lowest.end(), [percent](uint16_t value) { return value > percent; });
+        return it == lowest.end() ? UINT32_MAX : points[it - lowest.begin()].time;
+    }
+
+    uint16_t HealthTimeline::percentAt(uint32_t time) const
+    {
+        auto it = std::upper_bound(points.begin(), points.end(), time,
+            [](uint32_t time, const HealthPoint& point) { return time < point.time; });
+        return it == points.begin() ? 10000 : (it - 1)->percent;
+    }
+
+    void InstanceMap::clear()
+    {
+        intervals.clear();
+    }
+
+    void InstanceMap::add(uint16_t instid, uint64_t from, uint64_t to, uint64_t addr)
+    {
+        intervals.push_back(Interval{ instid, from, to, addr });
+    }
+
+    void InstanceMap::build()
+    {
+        //Holders that took an id at the same time are ordered by address, so lookups do not depend on add order
+        std::sort(intervals.begin(), intervals.end(), [](const Interval& lhs, const Interval& rhs) {
+            if (lhs.instid != rhs.instid) return lhs.instid < rhs.instid;
+            if (lhs.from != rhs.from) return lhs.from < rhs.from;
+            return lhs.addr < rhs.addr;
+        });
+    }
+
+    uint64_t InstanceMap::find(uint16_t instid, uint64_t time) const
+    {
+        //Last interval of this id that started at or before time
+        auto it = std::upper_bound(intervals.begin(), intervals.end(), std::make_pair(instid, time),
+            [](const std::pair<uint16_t, uint64_t>& key, const Interval& interval) {
+                return key.first < interval.instid || (key.first == interval.instid && key.second < interval.from);
+            });
+        if (it == intervals.begin()) {
+            return 0;
+        }
+        --it;
+        if (it->instid != instid || time > it->to) {
+            return 0;
+        }
+        return it->addr;
+    }
+
+    void EventIndex::build(const Parser& parser)
+    {
+        const TrackedVector<CombatEvent>& events = parser.events;
+        base_time = UINT64_MAX;
+        for (const CombatEvent& event : events) {
+            base_time = std::min(base_time, event.time);
+        }
+
+        //Agent index of each event per side, UINT32_MAX for addresses outside the agent table
+        std::vector<uint32_t> src_of_event(events.size(), UINT32_MAX);
+        std::vector<uint32_t> dst_of_event(events.size(), UINT32_MAX);
+        for (size_t i = 0; i < events.size(); ++i) {
+            auto src = parser.agents.find(events[i].src_agent);
+            if (src != parser.agents.end()) {
+                src_of_event[i] = src->second.index;
+            }
+            auto dst = parser.agents.find(events[i].dst_agent);
+            if (dst != parser.agents.end()) {
+                dst_of_event[i] = dst->second.index;
+            }
+        }
+
+        buildSide(source, src_of_event, events, parser.agents.size());
+        buildSide(destination, dst_of_event, events, parser.agents.size());
+    }
+
+    void EventIndex::buildSide(Side& side, const std::vector<uint32_t>& agent_of_event, const TrackedVector<CombatEvent>& events, size_t agent_count)
+    {
+        //Counting sort by agent, stable so each row stays in file order
+        side.offsets.assign(agent_count + 1, 0);
+        for (uint32_t agent : agent_of_event) {
+            if (agent < agent_count) {
+                side.offsets[agent + 1]++;
+            }
+        }
+        std::partial_sum(side.offsets.begin(), side.offsets.end(), side.offsets.begin());
+
+        side.events.resize(side.offsets.back());
+        side.times.resize(side.offsets.back());
+        std::vector<uint32_t> cursor(side.offsets.begin(), side.offsets.end() - 1);
+        for (size_t i = 0; i < agent_of_event.size(); ++i) {
+            uint32_t agent = agent_of_event[i];
+            if (agent < agent_count) {
+                uint32_t slot = cursor[agent]++;
+                side.events[slot] = (uint32_t)i;
+                side.times[slot] = (uint32_t)(events[i].time - base_time);
+            }
+        }
+
+        //Events are written almost in time order; the rare row that isn't gets sorted on its own
+        for (size_t agent = 0; agent < agent_count; ++agent) {
+            uint32_t begin = side.offsets[agent];
+            uint32_t end = side.offsets[agent + 1];
+            if (std::is_sorted(side.times.begin() + begin, side.times.begin() + end)) {
+                continue;
+            }
+            std::vector<std::pair<uint32_t, uint32_t>> row;
+            row.reserve(end - begin);
+            for (uint32_t i = begin; i < end; ++i) {
+                row.emplace_back(side.times[i], side.events[i]);
+            }
+            std::sort(row.begin(), row.end());
+            for (uint32_t i = begin; i < end; ++i) {
+                side.times[i] = row[i - begin].first;
+                side.events[i] = row[i - begin].second;
+            }
+        }
+    }
+
+    EventIndex::Range EventIndex::range(const Side& side, uint32_t agent_index) const
+    {
+        if (agent_index + 1 >= side.offsets.size()) {
+            return Range{ nullptr, nullptr };
+        }
+        const uint32_t* events = side.events.data();
+        return Range{ events + side.offsets[agent_index], events + side.offsets[agent_index + 1] };
+    }
+
+    EventIndex::Range EventIndex::range(const Side& side, uint32_t agent_index, uint64_t from, uint64_t to) const
+    {
+        if (agent_index + 1 >= side.offsets.size() || to <= from) {
+            return Range{ nullptr, nullptr };
+        }
+        //Clamp the bounds into the relative 32 bit time space
+        uint64_t rel_from = from > base_time ? std::min<uint64_t>(from - base_time, UINT32_MAX) : 0;
+        uint64_t rel_to = to > base_time ? std::min<uint64_t>(to - base_time, UINT32_MAX) : 0;
+        auto times_begin = side.times.begin() + side.offsets[agent_index];
+        auto times_end = side.times.begin() + side.offsets[agent_index + 1];
+        auto lower = std::lower_bound(times_begin, times_end, (uint32_t)rel_from);
+        auto upper = std::lower_bound(lower, times_end, (uint32_t)rel_to);
+        if (to > base_time && to - base_time > UINT32_MAX) {
+            upper = times_end;
+        }
+        const uint32_t* events = side.events.data();
+        return Range{ events + (lower - side.times.begin()), events + (upper - side.times.begin()) };
+    }
+
+    EventIndex::Range EventIndex::bySource(uint32_t agent_index) const
+    {
+        return range(source, agent_index);
+    }
+
+    EventIndex::Range EventIndex::byDestination(uint32_t agent_index) const
+    {
+        return range(destination, agent_index);
+    }
+
+    EventIndex::Range EventIndex::bySource(uint32_t agent_index, uint64_t from, uint64_t to) const
+    {
+        return range(source, agent_index, from, to);
+    }
+
+    EventIndex::Range EventIndex::byDestination(uint32_t agent_index, uint64_t from, uint64_t to) const
+    {
+        return range(destination, agent_index, from, to);
+    }
+
+    size_t EventIndex::memoryUsage() const
+    {
+        size_t bytes = 0;
+        for (const Side* side : { &source, &destination }) {
+            bytes += side->offsets.capacity() * sizeof(uint32_t);
+            bytes += side->events.capacity() * sizeof(uint32_t);
+            bytes += side->times.capacity() * sizeof(uint32_t);
+        }
+        return bytes;
+    }
+
     std::string Parser::encounterName(BossID area_id)
     {
         //TODO: Check if this would be faster as a hash table (likely not)
@@ -812,4 +1958,76 @@ namespace Revtc {
 		return type;
 	}
 
-}
\ No newline at end of file
+	static const BuffDef buff_table[] = {
+		//Boons
+		{ 740, "Might", BuffCategory::BOON, BuffStacking::INTENSITY, 25 },
+		{ 725, "Fury", BuffCategory::BOON, BuffStacking::DURATION, 9 },
+		{ 1187, "Quickness", BuffCategory::BOON, BuffStacking::DURATION, 5 },
+		{ 30328, "Alacrity", BuffCategory::BOON, BuffStacking::DURATION, 9 },
+		{ 717, "Protection", BuffCategory::BOON, BuffStacking::DURATION, 5 },
+		{ 718, "Regeneration", BuffCategory::BOON, BuffStacking::DURATION, 5 },
+		{ 726, "Vigor", BuffCategory::BOON, BuffStacking::DURATION, 5 },
+		{ 743, "Aegis", BuffCategory::BOON, BuffStacking::DURATION, 5 },
+		{ 1122, "Stability", BuffCategory::BOON, BuffStacking::INTENSITY, 25 },
+		{ 719, "Swiftness", BuffCategory::BOON, BuffStacking::DURATION, 9 },
+		{ 26980, "Resistance", BuffCategory::BOON, BuffStacking::DURATION, 5 },
+		{ 873, "Resolution", BuffCategory::BOON, BuffStacking::DURATION, 5 },
+		//Conditions
+		{ 736, "Bleeding", BuffCategory::CONDITION, BuffStacking::INTENSITY, 1500 },
+		{ 737, "Burning", BuffCategory::CONDITION, BuffStacking::INTENSITY, 1500 },
+		{ 861, "Confusion", BuffCategory::CONDITION, BuffStacking::INTENSITY, 1500 },
+		{ 723, "Poison", BuffCategory::CONDITION, BuffStacking::INTENSITY, 1500 },
+		{ 19426, "Torment", BuffCategory::CONDITION, BuffStacking::INTENSITY, 1500 },
+		{ 738, "Vulnerability", BuffCategory::CONDITION, BuffStacking::INTENSITY, 25 },
+		{ 720, "Blinded", BuffCategory::CONDITION, BuffStacking::DURATION, 9 },
+		{ 722, "Chilled", BuffCategory::CONDITION, BuffStacking::DURATION, 5 },
+		{ 721, "Crippled", BuffCategory::CONDITION, BuffStacking::DURATION, 9 },
+		{ 791, "Fear", BuffCategory::CONDITION, BuffStacking::DURATION, 5 },
+		{ 727, "Immobile", BuffCategory::CONDITION, BuffStacking::DURATION, 3 },
+		{ 26766, "Slow", BuffCategory::CONDITION, BuffStacking::DURATION, 9 },
+		{ 742, "Weakness", BuffCategory::CONDITION, BuffStacking::DURATION, 5 },
+		{ 27705, "Taunt", BuffCategory::CONDITION, BuffStacking::DURATION, 5 },
+	};
+
+	//(skill id, buff index) sorted by skill id
+	static const std::vector<std::pair<uint32_t, uint16_t>>& buffLookup()
+	{
+		static const std::vector<std::pair<uint32_t, uint16_t>> lookup = [] {
+			std::vector<std::pair<uint32_t, uint16_t>> sorted;
+			for (uint16_t i = 0; i < BuffRegistry::count(); ++i) {
+				sorted.emplace_back(buff_table[i].id, i);
+			}
+			std::sort(sorted.begin(), sorted.end());
+			return sorted;
+		}();
+		return lookup;
+	}
+
+	uint16_t BuffRegistry::count()
+	{
+		return (uint16_t)(sizeof(buff_table) / sizeof(buff_table[0]));
+	}
+
+	uint16_t BuffRegistry::boonCount()
+	{
+		static const uint16_t boons = (uint16_t)std::count_if(std::begin(buff_table), std::end(buff_table),
+			[](const BuffDef& def) { return def.category == BuffCategory::BOON; });
+		return boons;
+	}
+
+	const BuffDef& BuffRegistry::at(uint16_t index)
+	{
+		return buff_table[index];
+	}
+
+	uint16_t BuffRegistry::index(uint32_t skillid)
+	{
+		const auto& lookup = buffLookup();
+		auto it = std::lower_bound(lookup.begin(), lookup.end(), std::make_pair(skillid, (uint16_t)0));
+		if (it != lookup.end() && it->first == skillid) {
+			return it->second;
+		}
+		return BUFF_NONE;
+	}
+
+}
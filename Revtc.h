@@ -6,6 +6,9 @@
 #include <unordered_map>
 #include <queue>
 #include <set>
+#ifdef REVTC_MEMORY_STATS
+#include <atomic>
+#endif
 
 namespace Revtc {
 
@@ -24,6 +27,35 @@ namespace Revtc {
 		FURY = 0x2D5,
 	};
 
+	enum class BuffCategory : uint8_t {
+		BOON,
+		CONDITION,
+	};
+
+	enum class BuffStacking : uint8_t {
+		DURATION,
+		INTENSITY,
+	};
+
+	struct BuffDef {
+		uint32_t id;
+		const char* name;
+		BuffCategory category;
+		BuffStacking stacking;
+		uint16_t max_stacks;
+	};
+
+	const uint16_t BUFF_NONE = 0xFFFF;
+
+	//Tracked buffs. Buff indices are dense and boons come first, so [0, boonCount()) are boons.
+	class BuffRegistry {
+	public:
+		static uint16_t count();
+		static uint16_t boonCount();
+		static const BuffDef& at(uint16_t index);
+		static uint16_t index(uint32_t skillid); // BUFF_NONE if not tracked
+	};
+
 	enum class BossCategory : uint8_t
 	{
 		UNKNOWN = 0,
@@ -159,6 +191,30 @@ namespace Revtc {
 		CBTB_MANUAL, // autoremoved by ooc or allstack (ignore for strip/cleanse calc, use for in/out volume)
 	};
 
+	/* combat result (physical) */
+	enum cbtresult {
+		CBTR_NORMAL, // good physical hit
+		CBTR_CRIT, // physical hit was crit
+		CBTR_GLANCE, // physical hit was glance
+		CBTR_BLOCK, // physical hit was blocked eg. mesmer shield 4
+		CBTR_EVADE, // physical hit was evaded, eg. dodge or mesmer sword 2
+		CBTR_INTERRUPT, // physical hit interrupted something
+		CBTR_ABSORB, // physical hit was "invlun" or absorbed eg. guardian elite
+		CBTR_BLIND, // physical hit missed
+		CBTR_KILLINGBLOW, // physical hit was killing hit
+		CBTR_DOWNED // physical hit was downing hit
+	};
+
+	/* combat activation */
+	enum cbtactivation {
+		ACTV_NONE, // not used - not this kind of event
+		ACTV_NORMAL, // started skill activation without quickness
+		ACTV_QUICKNESS, // started skill activation with quickness
+		ACTV_CANCEL_FIRE, // stopped skill activation with reaching tooltip time
+		ACTV_CANCEL_CANCEL, // stopped skill activation without reaching tooltip time
+		ACTV_RESET // animation completed fully
+	};
+
 	struct CombatEventRev0 {
 		uint64_t time; /* timegettime() at time of event */
 		uint64_t src_agent; /* unique identifier */
@@ -228,8 +284,41 @@ namespace Revtc {
 		Player
 	};
 
+	//Incoming side of combat for one agent
+	struct DefenseStats {
+		uint32_t damage_taken; // physical and condition, barrier included
+		uint32_t barrier_absorbed;
+		uint32_t downs;
+		uint32_t deaths;
+		uint32_t blocked;
+		uint32_t evaded;
+		uint32_t invulned;
+		uint32_t missed; // attacker was blinded
+
+		DefenseStats& operator+=(const DefenseStats& rhs) {
+			damage_taken += rhs.damage_taken;
+			barrier_absorbed += rhs.barrier_absorbed;
+			downs += rhs.downs;
+			deaths += rhs.deaths;
+			blocked += rhs.blocked;
+			evaded += rhs.evaded;
+			invulned += rhs.invulned;
+			missed += rhs.missed;
+			return *this;
+		}
+	};
+
+	//Incoming damage from one skill
+	struct SkillDamageTaken {
+		uint32_t skillid;
+		uint32_t damage;
+		uint32_t barrier;
+		uint32_t hits;
+	};
+
 	struct Agent {
 		uint64_t addr;
+		uint32_t index; // position in the agent table
 		uint32_t prof;
 		uint32_t is_elite;
 		int16_t toughness;
@@ -252,8 +341,126 @@ namespace Revtc {
 		uint32_t boss_condi_damage;
 		uint32_t hits;
 		uint32_t note_counter;
+		uint16_t buff_slot; // BUFF_NONE if buffs are not tracked for this agent
+		uint32_t casts_begin; // range in Parser::casts
+		uint32_t casts_end;
+		DefenseStats defense;
+		uint32_t taken_begin; // range in Parser::damage_taken, players only
+		uint32_t taken_end;
+	};
+
+	//Allocation accounting. The Parser's large containers use TrackedAllocator, which charges every allocation
+	//to a MemoryCounter when REVTC_MEMORY_STATS is defined and is plain std::allocator otherwise. The define
+	//changes Parser's layout, so the library and everything including this header must agree on it.
+	enum class MemoryPool : uint8_t {
+		AGENTS,      // Parser::agents and the agent index
+		PLAYERS,     // Parser::players
+		SKILLS,      // Parser::skills and skill ids
+		EVENTS,      // Parser::events
+		BUFF_STACKS, // buff tracks and their stack events
+		REPLAY,      // active stack sets of the boon replay
+		COUNT
+	};
+
+	struct MemoryUsage {
+		uint64_t allocated;   // bytes allocated during the last parse
+		uint64_t allocations; // allocation calls during the last parse
+		uint64_t live;        // bytes held after the last parse, capacity kept for the next one included
+		uint64_t peak;        // most bytes held at once during the last parse
+	};
+
+	struct MemoryReport {
+		uint64_t events;
+		MemoryUsage total; // peak is the peak of the sum, not the sum of the peaks
+		MemoryUsage pools[(size_t)MemoryPool::COUNT];
+
+		const MemoryUsage& operator[](MemoryPool pool) const { return pools[(size_t)pool]; }
+		static const char* name(MemoryPool pool);
 	};
 
+	struct MemoryCounter;
+
+#ifdef REVTC_MEMORY_STATS
+	struct MemoryCounter {
+		MemoryCounter* parent = nullptr; // also charged, for totals
+		std::atomic<uint64_t> allocated{ 0 };
+		std::atomic<uint64_t> allocations{ 0 };
+		std::atomic<uint64_t> live{ 0 };
+		std::atomic<uint64_t> peak{ 0 };
+
+		void allocate(size_t bytes)
+		{
+			allocated.fetch_add(bytes, std::memory_order_relaxed);
+			allocations.fetch_add(1, std::memory_order_relaxed);
+			uint64_t now = live.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+			uint64_t seen = peak.load(std::memory_order_relaxed);
+			while (now > seen && !peak.compare_exchange_weak(seen, now, std::memory_order_relaxed)) {}
+			if (parent) {
+				parent->allocate(bytes);
+			}
+		}
+		void deallocate(size_t bytes)
+		{
+			live.fetch_sub(bytes, std::memory_order_relaxed);
+			if (parent) {
+				parent->deallocate(bytes);
+			}
+		}
+		//Starts a new measurement, what is still held counts towards the new peak
+		void restart()
+		{
+			allocated = 0;
+			allocations = 0;
+			peak = live.load();
+		}
+		MemoryUsage usage() const { return MemoryUsage{ allocated.load(), allocations.load(), live.load(), peak.load() }; }
+	};
+
+	template<typename T>
+	class TrackedAllocator {
+	public:
+		using value_type = T;
+
+		MemoryCounter* counter; // nullptr counts nothing
+
+		TrackedAllocator(MemoryCounter* counter = nullptr) noexcept : counter(counter) {}
+		template<typename U> TrackedAllocator(const TrackedAllocator<U>& other) noexcept : counter(other.counter) {}
+
+		T* allocate(size_t n)
+		{
+			T* p = std::allocator<T>().allocate(n);
+			if (counter) {
+				counter->allocate(n * sizeof(T));
+			}
+			return p;
+		}
+		void deallocate(T* p, size_t n) noexcept
+		{
+			if (counter) {
+				counter->deallocate(n * sizeof(T));
+			}
+			std::allocator<T>().deallocate(p, n);
+		}
+
+		template<typename U> bool operator==(const TrackedAllocator<U>& rhs) const noexcept { return counter == rhs.counter; }
+		template<typename U> bool operator!=(const TrackedAllocator<U>& rhs) const noexcept { return counter != rhs.counter; }
+	};
+#else
+	template<typename T>
+	class TrackedAllocator : public std::allocator<T> {
+	public:
+		template<typename U> struct rebind { using other = TrackedAllocator<U>; };
+
+		TrackedAllocator(MemoryCounter* = nullptr) noexcept {}
+		template<typename U> TrackedAllocator(const TrackedAllocator<U>&) noexcept {}
+	};
+#endif
+
+	template<typename T>
+	using TrackedVector = std::vector<T, TrackedAllocator<T>>;
+	template<typename K, typename V>
+	using TrackedMap = std::unordered_map<K, V, std::hash<K>, std::equal_to<K>, TrackedAllocator<std::pair<const K, V>>>;
+
 	struct BoonStack {
 		uint64_t start_time;
 		uint64_t duration;
@@ -273,16 +480,95 @@ namespace Revtc {
 		friend inline bool operator<(const BoonStack& lhs, const BoonStack& rhs);
 	};
 
+	//Buff state of one tracked agent for one buff
 	struct Boon {
-		uint32_t id;
-		std::string name;
-		bool intensity;
-		uint8_t max_stacks;
-		std::vector<BoonStack> stacks;
-		std::vector<BoonStack> replay;
+		uint16_t index;
+		uint32_t stacks_begin; // stack events are Parser::buff_stacks[stacks_begin, stacks_end)
+		uint32_t stacks_end;
 		float average;
 	};
 
+	//Active stacks during replay. Stacks are keyed by buff_instid (stacks without one get a private key),
+	//stored densely for O(1) insert, remove and size, and expired through a min-heap on end time.
+	//Intensity stacks all tick at once. Duration stacks queue: only the longest ticks and the others keep their
+	//remaining time until they get their turn, so back-to-back applications add up instead of overlapping.
+	class BoonStackSet {
+		struct Expiry {
+			uint64_t end_time;
+			uint64_t key;
+
+			bool operator>(const Expiry& rhs) const { return end_time > rhs.end_time; }
+		};
+
+		//Queued duration stack, remaining is frozen while it waits
+		struct Waiting {
+			uint64_t remaining;
+			uint64_t key;
+
+			bool operator<(const Waiting& rhs) const { return remaining < rhs.remaining; }
+			bool operator>(const Waiting& rhs) const { return remaining > rhs.remaining; }
+		};
+
+		//Open addressing key -> position table, keeps its capacity across clear() unlike a node based map
+		struct Slot {
+			uint64_t key; // 0 marks an empty slot
+			uint32_t position;
+		};
+
+		//A ticking stack runs over [start_time, start_time + duration). A waiting one holds its remaining time in duration.
+		TrackedVector<BoonStack> stacks;
+		TrackedVector<uint64_t> keys;
+		TrackedVector<Slot> table;
+		TrackedVector<Expiry> heap; // ticking stacks, entries go stale when their stack changes or leaves
+		TrackedVector<Waiting> longest; // waiting duration stacks, max-heap, stale entries as above
+		TrackedVector<Waiting> shortest; // the same as a min-heap, for eviction
+		uint64_t next_private_key;
+		BuffStacking stacking;
+		uint64_t ticking; // key of the ticking duration stack, 0 for none
+
+		void erase(uint32_t position);
+		void tick(uint64_t key, uint64_t time);
+		void wait(uint64_t key);
+		void promote(uint64_t time);
+		bool current(const Waiting& entry);
+		uint64_t firstOut(uint64_t time, uint64_t& remaining);
+		size_t slotOf(uint64_t key) const;
+		uint32_t* find(uint64_t key);
+		void put(uint64_t key, uint32_t position);
+		void unput(uint64_t key);
+	public:
+		explicit BoonStackSet(MemoryCounter* counter = nullptr);
+
+		//Empties the set for a buff with the given stacking rule
+		void reset(BuffStacking stacking);
+		void clear();
+		size_t size() const { return stacks.size(); }
+		//Over max_stacks the stack that runs out first makes room, unless the new one would run out before it.
+		//O(log n) in the number of stacks.
+		void insert(const BoonStack& stack, uint16_t max_stacks);
+		bool remove(uint32_t buff_instid, uint64_t time);
+		bool extend(uint32_t buff_instid, uint64_t duration, uint64_t time);
+		uint64_t nextExpiry();
+		void expire(uint64_t time);
+	};
+
+	enum class CastOutcome : uint8_t {
+		UNFINISHED, // no end event before the next cast or the end of the log
+		COMPLETED,  // ACTV_RESET
+		FIRED,      // ACTV_CANCEL_FIRE, stopped after the skill went off
+		CANCELLED,  // ACTV_CANCEL_CANCEL, stopped before the skill went off
+	};
+
+	const uint16_t CAST_SKILL_UNKNOWN = 0xFFFF;
+
+	struct Cast {
+		uint32_t start;    // ms after log start
+		uint32_t duration; // ms, 0 if unfinished
+		uint16_t skill;    // Skill::index, CAST_SKILL_UNKNOWN if the skill table lacks the id
+		CastOutcome outcome;
+		bool quickness;
+	};
+
 	struct Player {
 		uint64_t addr;
 		std::string name;
@@ -294,10 +580,11 @@ namespace Revtc {
 		std::string elite_spec_name;
 		std::string elite_spec_name_short;
 		uint16_t subgroup;
+		uint16_t slot;
 		uint64_t first_aware;
 		uint64_t last_aware;
 
-		std::set<uint64_t> slaves;
+		std::vector<uint64_t> slaves; // sorted
 		
 		uint32_t physical_damage;
 		uint32_t condi_damage;
@@ -307,7 +594,11 @@ namespace Revtc {
 		uint32_t boss_condi_damage;
 		uint32_t boss_dps;
 
-		std::map<BoonType, Boon> boons;
+		std::vector<float> buffs; // average stacks by buff index
+		std::vector<Cast> casts; // by start time
+
+		DefenseStats defense;
+		std::vector<SkillDamageTaken> damage_taken; // by skill id
 
 		float might_avg;
 		float quickness_avg;
@@ -320,8 +611,60 @@ namespace Revtc {
 		friend inline bool operator<(const Player& lhs, const Player& rhs);
 	};
 
+	//Outgoing boon generation in milliseconds (extensions included, overstack excluded)
+	//Dense [src slot][dst slot][boon index] matrix, slots are Player::slot. Self-applications land on the diagonal.
+	struct BoonGeneration {
+		uint16_t player_count;
+		uint16_t boon_count;
+		std::vector<uint32_t> ms;
+
+		//Milliseconds a buff application credits to its src. Extensions (is_offcycle) count in full,
+		//other applications without the part that overstacked. Shared by Parser and WvwParser.
+		static uint32_t contributed(const CombatEvent& event) {
+			if (event.value <= 0) {
+				return 0;
+			}
+			if (event.is_offcycle) {
+				return (uint32_t)event.value;
+			}
+			return (uint32_t)event.value > event.overstack_value ? (uint32_t)event.value - event.overstack_value : 0;
+		}
+
+		uint32_t& at(uint16_t src, uint16_t dst, uint16_t boon) {
+			return ms[((size_t)src * player_count + dst) * boon_count + boon];
+		}
+		uint32_t at(uint16_t src, uint16_t dst, uint16_t boon) const {
+			return ms[((size_t)src * player_count + dst) * boon_count + boon];
+		}
+	};
+
+	struct HealthPoint {
+		uint32_t time;    // ms after log start
+		uint16_t percent; // percent * 100, 10000 is full health
+	};
+
+	struct MaxHealthPoint {
+		uint32_t time; // ms after log start
+		uint64_t value;
+	};
+
+	//Health of one boss agent over the log
+	struct HealthTimeline {
+		uint64_t addr;
+		uint16_t species_id;
+		std::vector<HealthPoint> points; // by time
+		std::vector<uint16_t> lowest; // lowest[i] is the minimum percent of points[0..i]
+		std::vector<MaxHealthPoint> max_health; // by time
+
+		//First time the boss was at or below percent (* 100), UINT32_MAX if it never got there
+		uint32_t timeAt(uint16_t percent) const;
+		//Last recorded percent (* 100) at or before time, 10000 before the first update
+		uint16_t percentAt(uint32_t time) const;
+	};
+
 	struct Skill {
 		int32_t id;
+		uint32_t index; // position in the skill table
 		std::string name;
 	};
 
@@ -332,34 +675,200 @@ namespace Revtc {
 		std::set<uint16_t> boss_ids;
 		std::string encounter_name;
 		bool valid;
-		std::string error;
+		std::string error; // why the log is invalid, or for a valid log a note on damage that was skipped
 
 		std::vector<Player> players;
+		BoonGeneration generation;
+		std::vector<float> boss_buffs; // average stacks by buff index
+		std::vector<HealthTimeline> boss_health; // by agent table order
 		uint64_t reward_at;
 		uint64_t log_start;
 		uint64_t log_end;
+		uint32_t server_start; // CBTS_LOGSTART server unix timestamp, 0 if the log has none
 		uint64_t boss_lifetime;
 		uint64_t boss_death;
 		uint64_t encounter_duration;
+		uint64_t encounter_duration_ms;
+	};
+
+	class Parser;
+
+	//Resolves game instance ids to agent addresses at a point in time. Ids are reused over long logs and an agent
+	//can change ids, so every time an agent held an id is kept as an interval [from, to], sorted by (id, from).
+	//Both ends are inclusive; where two holders of an id overlap, the one that took it later wins.
+	class InstanceMap
+	{
+	public:
+		void clear();
+		void add(uint16_t instid, uint64_t from, uint64_t to, uint64_t addr);
+		void build(); // call once after the last add
+		uint64_t find(uint16_t instid, uint64_t time) const; // 0 if no agent held instid at time
+
+	private:
+		struct Interval {
+			uint16_t instid;
+			uint64_t from;
+			uint64_t to;
+			uint64_t addr;
+		};
+
+		std::vector<Interval> intervals;
+	};
+
+	//Per-agent event lists in compressed sparse row form, built once after decode. For each side (source and
+	//destination) the events of agent i are entries [offsets[i], offsets[i + 1]) in time order, each entry being the
+	//event's position in Parser::events and its time relative to base_time.
+	//Memory is 8 bytes per indexed event per side plus 4 bytes per agent per side.
+	class EventIndex
+	{
+	public:
+		struct Range {
+			const uint32_t* begin;
+			const uint32_t* end;
+
+			size_t size() const { return end - begin; }
+		};
+
+		void build(const Parser& parser);
+
+		//Positions in Parser::events, optionally restricted to from <= time < to
+		Range bySource(uint32_t agent_index) const;
+		Range byDestination(uint32_t agent_index) const;
+		Range bySource(uint32_t agent_index, uint64_t from, uint64_t to) const;
+		Range byDestination(uint32_t agent_index, uint64_t from, uint64_t to) const;
+
+		size_t memoryUsage() const;
+
+	private:
+		struct Side {
+			std::vector<uint32_t> offsets;
+			std::vector<uint32_t> events;
+			std::vector<uint32_t> times;
+		};
+
+		uint64_t base_time;
+		Side source;
+		Side destination;
+
+		void buildSide(Side& side, const std::vector<uint32_t>& agent_of_event, const TrackedVector<CombatEvent>& events, size_t agent_count);
+		Range range(const Side& side, uint32_t agent_index) const;
+		Range range(const Side& side, uint32_t agent_index, uint64_t from, uint64_t to) const;
 	};
 
 	class Parser
 	{
+		//Per-chunk results of the event passes, merged in file order so any thread count gives the same Log
+		struct AgentAwareness {
+			uint64_t first_aware;
+			uint64_t last_aware;
+			uint16_t instance_id;
+			uint16_t run_instid; // last nonzero instance id in the chunk
+			bool seen;
+			bool has_instance;
+		};
+
+		//An agent taking up an instance id
+		struct InstanceRun {
+			uint32_t agent; // index
+			uint16_t instid;
+			uint64_t time; // first event with the id
+		};
+
+		struct AgentTotals {
+			uint32_t direct_damage;
+			uint32_t boss_direct_damage;
+			uint32_t condi_damage;
+			uint32_t boss_condi_damage;
+			uint32_t hits;
+			uint32_t note_counter;
+			DefenseStats defense;
+		};
+
+		struct EventChunk {
+			size_t begin;
+			size_t end;
+			bool has_log_start;
+			bool has_log_end;
+			uint64_t log_start;
+			uint64_t log_end;
+			uint32_t server_start;
+			uint64_t reward_at;
+			uint64_t boss_death;
+			std::vector<AgentAwareness> awareness; // by agent index
+			std::vector<InstanceRun> instance_runs; // in event order
+			std::vector<uint64_t> masters; // by agent index
+			std::vector<std::pair<uint64_t, uint64_t>> slaves; // (master, slave)
+			std::vector<AgentTotals> totals; // by agent index
+			std::vector<std::pair<uint32_t, BoonStack>> stacks; // (buff track, stack) in event order
+			std::vector<uint32_t> generation;
+			std::vector<std::pair<uint32_t, Cast>> casts; // (agent index, cast) in event order
+			std::vector<uint32_t> cast_open; // by agent index: position in casts, CAST_NONE or CAST_CLOSED
+			std::vector<std::pair<uint32_t, Cast>> cast_ends; // end events before any start of their agent, start is the end time
+			std::vector<std::pair<uint32_t, HealthPoint>> health; // (agent index, point) of bosses in event order
+			std::vector<std::pair<uint32_t, MaxHealthPoint>> max_health;
+			std::vector<uint32_t> taken_positions; // by player slot * skill count + Skill::index: position in taken, TAKEN_NONE if unhit
+			std::vector<uint32_t> taken_cells; // entries of taken_positions in use, the rest are TAKEN_NONE
+			std::unordered_map<uint64_t, uint32_t> unlisted_positions; // (agent index << 32 | skill id) for skills missing from the table
+			std::vector<std::pair<uint64_t, SkillDamageTaken>> taken;
+		};
+
+		static const size_t MIN_CHUNK_EVENTS = 16 * 1024;
+		static const uint32_t CAST_NONE = UINT32_MAX;
+		static const uint32_t CAST_CLOSED = UINT32_MAX - 1;
+		static const uint32_t TAKEN_NONE = UINT32_MAX;
+
 		const unsigned char* buf;
 		size_t buf_len;
 		uint64_t boss_addr;
+#ifdef REVTC_MEMORY_STATS
+		MemoryCounter memory_total;
+		MemoryCounter memory_pools[(size_t)MemoryPool::COUNT];
+#endif
+		TrackedVector<Agent*> agent_by_index;
+		std::vector<EventChunk> chunks;
+		std::vector<InstanceRun> open_runs; // by agent index, the id each agent holds while building instances
+		std::vector<BoonStackSet> worker_stacks; // active stacks of the replay threads after the first
+		std::vector<TrackedMap<uint64_t, Agent>::node_type> spare_agents;
+		std::vector<TrackedMap<uint64_t, Player>::node_type> spare_players;
+		std::vector<TrackedMap<int32_t, Skill>::node_type> spare_skills;
+
+		MemoryCounter* memoryCounter(MemoryPool pool); // nullptr without REVTC_MEMORY_STATS
+
+		template<typename Fn> void forEachChunk(Fn&& fn);
+		void decodeChunk(EventChunk& chunk, size_t events_offset, uint8_t revision);
+		void mapMastersChunk(EventChunk& chunk);
+		template<typename Encounter> void extractChunk(EventChunk& chunk, const Log& log);
+		void replayTrack(Boon& boon, BoonStackSet& active, uint64_t log_start, uint64_t encounter_duration);
 	public:
-		std::unordered_map<uint64_t, Agent> agents;
-		std::unordered_map<uint16_t, uint64_t> agent_addrs;
-		std::unordered_map<uint64_t, Player> players;
-		std::unordered_map<int32_t, Skill> skills;
-		std::vector<CombatEvent> events;
+		unsigned threads; // threads for the event passes and boon replay, 1 runs everything on the calling thread
+		TrackedMap<uint64_t, Agent> agents;
+		InstanceMap instances;
+		TrackedMap<uint64_t, Player> players;
+		TrackedMap<int32_t, Skill> skills;
+		TrackedVector<CombatEvent> events;
+		TrackedVector<uint64_t> buff_agents; // addr by buff slot
+		TrackedVector<Boon> buff_tracks; // [buff slot * BuffRegistry::count() + buff index]
+		TrackedVector<BoonStack> buff_stacks;
+		BoonStackSet active_stacks;
+		TrackedVector<int32_t> skill_ids; // by Skill::index
+		std::vector<Cast> casts; // grouped by agent (Agent::casts_begin/casts_end), by start time within an agent
+		std::vector<SkillDamageTaken> damage_taken; // grouped by agent (Agent::taken_begin/taken_end), by skill id within an agent
 
 		Parser(const unsigned char* buf, size_t len);
 		~Parser();
 
+		//Parsing clears the containers above but keeps their capacity, so one long-lived Parser per worker
+		//thread stops allocating once it has seen its largest log. The Log overload also reuses the caller's Log.
+		void reset(const unsigned char* buf, size_t len);
 		Log parse();
+		Log parse(const unsigned char* buf, size_t len);
+		void parse(const unsigned char* buf, size_t len, Log& log);
 		void replay_boons(uint64_t log_start, uint64_t encounter_duration);
+		//Bytes allocated and held by the tracked containers during the last parse, all zero without REVTC_MEMORY_STATS
+		MemoryReport memoryReport() const;
+		//Decodes one event record of the given revision
+		static void decodeEvent(const unsigned char* record, uint8_t revision, CombatEvent& event);
+		static uint64_t activeStacks(const BoonStackSet& active, const BuffDef& def);
 		static std::string encounterName(BossID area_id);
 		static BossCategory encounterCategory(BossID area_id);
 		static std::pair<std::string, std::string> professionName(uint32_t prof);
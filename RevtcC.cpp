@@ -0,0 +1,302 @@
+#include "RevtcC.h"
+#include "Revtc.h"
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+
+struct revtc_parser {
+    Revtc::Parser parser;
+    Revtc::Log log;
+
+    revtc_parser() : parser(nullptr, 0) {}
+};
+
+namespace Revtc {
+
+    static const uint32_t NO_STRING = UINT32_MAX;
+
+    static size_t align8(size_t n)
+    {
+        return (n + 7) & ~(size_t)7;
+    }
+
+    //Strings are collected first, the table goes at the end of the block once its base is known
+    class StringTable {
+    public:
+        uint32_t add(const std::string& s) { return add(s.c_str(), s.size()); }
+        uint32_t add(const char* s, size_t len)
+        {
+            if (len == 0) {
+                return NO_STRING;
+            }
+            uint32_t offset = (uint32_t)pool.size();
+            pool.append(s, len).push_back('\0');
+            return offset;
+        }
+        uint32_t resolve(uint32_t offset, size_t base) const { return offset == NO_STRING ? 0 : (uint32_t)(base + offset); }
+
+        std::string pool;
+    };
+
+    static const revtc_header* flatten(const Parser& parser, const Log& log)
+    {
+        const uint16_t buff_count = BuffRegistry::count();
+        const uint16_t boon_count = BuffRegistry::boonCount();
+        const size_t player_count = log.players.size();
+
+        StringTable strings;
+        uint32_t error = strings.add(log.error);
+        uint32_t evtc_version = strings.add(log.version);
+        uint32_t encounter_name = strings.add(log.encounter_name);
+        std::vector<uint32_t> buff_names(buff_count);
+        for (uint16_t i = 0; i < buff_count; ++i) {
+            const char* name = BuffRegistry::at(i).name;
+            buff_names[i] = strings.add(name, strlen(name));
+        }
+        std::vector<uint32_t> player_strings(player_count * 5);
+        for (size_t i = 0; i < player_count; ++i) {
+            const Player& player = log.players[i];
+            player_strings[i * 5 + 0] = strings.add(player.name);
+            player_strings[i * 5 + 1] = strings.add(player.account);
+            player_strings[i * 5 + 2] = strings.add(player.profession_name);
+            player_strings[i * 5 + 3] = strings.add(player.elite_spec_name);
+            player_strings[i * 5 + 4] = strings.add(player.note);
+        }
+
+        //Layout
+        size_t size = align8(sizeof(revtc_header));
+        const size_t buffs_at = size;
+        size += align8(buff_count * sizeof(revtc_buff));
+        const size_t players_at = size;
+        size += align8(player_count * sizeof(revtc_player));
+        const size_t boss_buffs_at = log.boss_buffs.empty() ? 0 : size;
+        size += align8(log.boss_buffs.size() * sizeof(float));
+        const size_t generation_at = log.generation.ms.empty() ? 0 : size;
+        size += align8(log.generation.ms.size() * sizeof(uint32_t));
+        std::vector<size_t> arrays_at(player_count * 3);
+        for (size_t i = 0; i < player_count; ++i) {
+            const Player& player = log.players[i];
+            arrays_at[i * 3 + 0] = player.buffs.empty() ? 0 : size;
+            size += align8(player.buffs.size() * sizeof(float));
+            arrays_at[i * 3 + 1] = player.casts.empty() ? 0 : size;
+            size += align8(player.casts.size() * sizeof(revtc_cast));
+            arrays_at[i * 3 + 2] = player.damage_taken.empty() ? 0 : size;
+            size += align8(player.damage_taken.size() * sizeof(revtc_damage_taken));
+        }
+        const size_t health_count = log.boss_health.size();
+        const size_t health_at = health_count ? size : 0;
+        size += align8(health_count * sizeof(revtc_health));
+        std::vector<size_t> points_at(health_count * 2);
+        for (size_t i = 0; i < health_count; ++i) {
+            const HealthTimeline& timeline = log.boss_health[i];
+            points_at[i * 2 + 0] = timeline.points.empty() ? 0 : size;
+            size += align8(timeline.points.size() * sizeof(revtc_health_point));
+            points_at[i * 2 + 1] = timeline.max_health.empty() ? 0 : size;
+            size += align8(timeline.max_health.size() * sizeof(revtc_max_health));
+        }
+        const size_t strings_at = size;
+        size += align8(strings.pool.size());
+
+        uint8_t* block = (uint8_t*)calloc(1, size);
+        if (!block) {
+            return nullptr;
+        }
+
+        revtc_header* header = (revtc_header*)block;
+        header->magic = REVTC_FLAT_MAGIC;
+        header->version = REVTC_FLAT_VERSION;
+        header->size = size;
+        header->valid = log.valid;
+        header->revision = log.revision;
+        header->area_id = (uint16_t)log.area_id;
+        header->error = strings.resolve(error, strings_at);
+        header->evtc_version = strings.resolve(evtc_version, strings_at);
+        header->encounter_name = strings.resolve(encounter_name, strings_at);
+        header->log_start = log.log_start;
+        header->log_end = log.log_end;
+        header->reward_at = log.reward_at;
+        header->boss_death = log.boss_death;
+        header->boss_lifetime = log.boss_lifetime;
+        header->encounter_duration_ms = log.encounter_duration_ms;
+        header->player_count = (uint32_t)player_count;
+        header->player_size = sizeof(revtc_player);
+        header->players = player_count ? players_at : 0;
+        header->buff_count = buff_count;
+        header->boon_count = boon_count;
+        header->buffs = buffs_at;
+        header->boss_buffs = boss_buffs_at;
+        header->generation = generation_at;
+        header->strings = strings_at;
+        header->strings_size = strings.pool.size();
+        header->boss_health_count = (uint32_t)health_count;
+        header->boss_health_size = sizeof(revtc_health);
+        header->boss_health = health_at;
+
+        revtc_buff* buffs = (revtc_buff*)(block + buffs_at);
+        for (uint16_t i = 0; i < buff_count; ++i) {
+            const BuffDef& def = BuffRegistry::at(i);
+            buffs[i].id = def.id;
+            buffs[i].name = strings.resolve(buff_names[i], strings_at);
+            buffs[i].category = (uint8_t)def.category;
+            buffs[i].stacking = (uint8_t)def.stacking;
+            buffs[i].max_stacks = def.max_stacks;
+        }
+
+        revtc_player* players = (revtc_player*)(block + players_at);
+        for (size_t i = 0; i < player_count; ++i) {
+            const Player& player = log.players[i];
+            revtc_player& out = players[i];
+            out.addr = player.addr;
+            out.name = strings.resolve(player_strings[i * 5 + 0], strings_at);
+            out.account = strings.resolve(player_strings[i * 5 + 1], strings_at);
+            out.profession_name = strings.resolve(player_strings[i * 5 + 2], strings_at);
+            out.elite_spec_name = strings.resolve(player_strings[i * 5 + 3], strings_at);
+            out.note = strings.resolve(player_strings[i * 5 + 4], strings_at);
+            out.profession = player.profession;
+            out.elite_spec = player.elite_spec;
+            out.subgroup = player.subgroup;
+            out.slot = player.slot;
+            out.first_aware = player.first_aware;
+            out.last_aware = player.last_aware;
+            out.physical_damage = player.physical_damage;
+            out.condi_damage = player.condi_damage;
+            out.dps = player.dps;
+            out.boss_physical_damage = player.boss_physical_damage;
+            out.boss_condi_damage = player.boss_condi_damage;
+            out.boss_dps = player.boss_dps;
+            out.damage_taken = player.defense.damage_taken;
+            out.barrier_absorbed = player.defense.barrier_absorbed;
+            out.downs = player.defense.downs;
+            out.deaths = player.defense.deaths;
+            out.blocked = player.defense.blocked;
+            out.evaded = player.defense.evaded;
+            out.invulned = player.defense.invulned;
+            out.missed = player.defense.missed;
+
+            out.buffs = arrays_at[i * 3 + 0];
+            if (!player.buffs.empty()) {
+                memcpy(block + out.buffs, player.buffs.data(), player.buffs.size() * sizeof(float));
+            }
+
+            out.casts = arrays_at[i * 3 + 1];
+            out.cast_count = (uint32_t)player.casts.size();
+            revtc_cast* casts = (revtc_cast*)(block + out.casts);
+            for (size_t c = 0; c < player.casts.size(); ++c) {
+                const Cast& cast = player.casts[c];
+                casts[c].start = cast.start;
+                casts[c].duration = cast.duration;
+                casts[c].skill_id = cast.skill < parser.skill_ids.size() ? (uint32_t)parser.skill_ids[cast.skill] : 0;
+                casts[c].outcome = (uint8_t)cast.outcome;
+                casts[c].quickness = cast.quickness;
+            }
+
+            out.damage_taken_by_skill = arrays_at[i * 3 + 2];
+            out.damage_taken_count = (uint32_t)player.damage_taken.size();
+            revtc_damage_taken* taken = (revtc_damage_taken*)(block + out.damage_taken_by_skill);
+            for (size_t t = 0; t < player.damage_taken.size(); ++t) {
+                taken[t].skill_id = player.damage_taken[t].skillid;
+                taken[t].damage = player.damage_taken[t].damage;
+                taken[t].barrier = player.damage_taken[t].barrier;
+                taken[t].hits = player.damage_taken[t].hits;
+            }
+        }
+
+        revtc_health* health = (revtc_health*)(block + health_at);
+        for (size_t i = 0; i < health_count; ++i) {
+            const HealthTimeline& timeline = log.boss_health[i];
+            revtc_health& out = health[i];
+            out.addr = timeline.addr;
+            out.species_id = timeline.species_id;
+            out.points = points_at[i * 2 + 0];
+            out.point_count = (uint32_t)timeline.points.size();
+            revtc_health_point* points = (revtc_health_point*)(block + out.points);
+            for (size_t p = 0; p < timeline.points.size(); ++p) {
+                points[p].time = timeline.points[p].time;
+                points[p].percent = timeline.points[p].percent;
+            }
+            out.max_health = points_at[i * 2 + 1];
+            out.max_health_count = (uint32_t)timeline.max_health.size();
+            revtc_max_health* max_health = (revtc_max_health*)(block + out.max_health);
+            for (size_t p = 0; p < timeline.max_health.size(); ++p) {
+                max_health[p].time = timeline.max_health[p].time;
+                max_health[p].value = timeline.max_health[p].value;
+            }
+        }
+
+        if (boss_buffs_at) {
+            memcpy(block + boss_buffs_at, log.boss_buffs.data(), log.boss_buffs.size() * sizeof(float));
+        }
+        if (generation_at) {
+            memcpy(block + generation_at, log.generation.ms.data(), log.generation.ms.size() * sizeof(uint32_t));
+        }
+        memcpy(block + strings_at, strings.pool.data(), strings.pool.size());
+        return header;
+    }
+
+    static const revtc_header* parseFlat(revtc_parser& state, const uint8_t* data, size_t len)
+    {
+        //Exceptions must not cross the C boundary, they become an invalid result
+        try {
+            state.parser.parse(data, len, state.log);
+        }
+        catch (const std::exception& e) {
+            state.log.valid = false;
+            state.log.error = e.what();
+            state.log.players.clear();
+        }
+        catch (...) {
+            state.log.valid = false;
+            state.log.error = "Unknown error while parsing.";
+            state.log.players.clear();
+        }
+        try {
+            return flatten(state.parser, state.log);
+        }
+        catch (...) {
+            return nullptr;
+        }
+    }
+
+}
+
+extern "C" {
+
+const revtc_header* revtc_parse(const uint8_t* data, size_t len)
+{
+    revtc_parser* parser = revtc_parser_new(1);
+    if (!parser) {
+        return nullptr;
+    }
+    const revtc_header* result = Revtc::parseFlat(*parser, data, len);
+    revtc_parser_free(parser);
+    return result;
+}
+
+revtc_parser* revtc_parser_new(unsigned threads)
+{
+    try {
+        revtc_parser* parser = new revtc_parser();
+        parser->parser.threads = threads ? threads : 1;
+        return parser;
+    }
+    catch (...) {
+        return nullptr;
+    }
+}
+
+const revtc_header* revtc_parser_parse(revtc_parser* parser, const uint8_t* data, size_t len)
+{
+    return parser ? Revtc::parseFlat(*parser, data, len) : nullptr;
+}
+
+void revtc_parser_free(revtc_parser* parser)
+{
+    delete parser;
+}
+
+void revtc_free(const revtc_header* result)
+{
+    free((void*)result);
+}
+
+}
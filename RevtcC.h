@@ -0,0 +1,158 @@
+#pragma once
+
+/* C interface. A parse returns one malloc'd block holding the whole result: a header, fixed size records
+ * and a string table, all linked by byte offsets from the start of the block. Foreign callers can map the
+ * structs below straight onto the block and release it with a single revtc_free().
+ *
+ * Every offset is from the start of the block, an offset of 0 means absent (or an empty string). Records
+ * and arrays are 8 byte aligned, integers are native endian. */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define REVTC_FLAT_MAGIC 0x54414C46u /* "FLAT" */
+#define REVTC_FLAT_VERSION 2u /* 2 added boss_health */
+
+typedef struct revtc_header {
+	uint32_t magic;
+	uint32_t version;
+	uint64_t size; /* bytes in the block */
+
+	uint8_t valid;
+	uint8_t revision;
+	uint16_t area_id;
+	uint32_t error; /* string */
+	uint32_t evtc_version; /* string */
+	uint32_t encounter_name; /* string */
+
+	uint64_t log_start;
+	uint64_t log_end;
+	uint64_t reward_at;
+	uint64_t boss_death;
+	uint64_t boss_lifetime;
+	uint64_t encounter_duration_ms;
+
+	uint32_t player_count;
+	uint32_t player_size; /* sizeof(revtc_player) when written, step by this to stay compatible */
+	uint64_t players; /* revtc_player[player_count] */
+
+	uint32_t buff_count;
+	uint32_t boon_count; /* the first boon_count buffs are boons */
+	uint64_t buffs; /* revtc_buff[buff_count] */
+	uint64_t boss_buffs; /* float[buff_count], average stacks on the boss */
+	uint64_t generation; /* uint32_t[player_count][player_count][boon_count], ms from src slot to dst slot */
+
+	uint64_t strings; /* NUL terminated strings */
+	uint64_t strings_size;
+
+	uint32_t boss_health_count;
+	uint32_t boss_health_size; /* sizeof(revtc_health) when written */
+	uint64_t boss_health; /* revtc_health[boss_health_count], agent table order */
+} revtc_header;
+
+typedef struct revtc_buff {
+	uint32_t id;
+	uint32_t name; /* string */
+	uint8_t category; /* 0 boon, 1 condition */
+	uint8_t stacking; /* 0 duration, 1 intensity */
+	uint16_t max_stacks;
+	uint32_t pad;
+} revtc_buff;
+
+typedef struct revtc_cast {
+	uint32_t start; /* ms after log start */
+	uint32_t duration;
+	uint32_t skill_id;
+	uint8_t outcome; /* 0 unfinished, 1 completed, 2 fired, 3 cancelled */
+	uint8_t quickness;
+	uint16_t pad;
+} revtc_cast;
+
+typedef struct revtc_damage_taken {
+	uint32_t skill_id;
+	uint32_t damage;
+	uint32_t barrier;
+	uint32_t hits;
+} revtc_damage_taken;
+
+typedef struct revtc_health_point {
+	uint32_t time; /* ms after log start */
+	uint16_t percent; /* percent * 100, 10000 is full health */
+	uint16_t pad;
+} revtc_health_point;
+
+typedef struct revtc_max_health {
+	uint32_t time; /* ms after log start */
+	uint32_t pad;
+	uint64_t value;
+} revtc_max_health;
+
+typedef struct revtc_health {
+	uint64_t addr;
+	uint16_t species_id;
+	uint16_t pad;
+	uint32_t point_count;
+	uint64_t points; /* revtc_health_point[point_count], by time */
+	uint64_t max_health; /* revtc_max_health[max_health_count], by time */
+	uint32_t max_health_count;
+	uint32_t pad2;
+} revtc_health;
+
+typedef struct revtc_player {
+	uint64_t addr;
+	uint32_t name; /* string */
+	uint32_t account; /* string */
+	uint32_t profession_name; /* string */
+	uint32_t elite_spec_name; /* string */
+	uint32_t note; /* string */
+	uint32_t profession;
+	uint32_t elite_spec;
+	uint16_t subgroup;
+	uint16_t slot; /* index into the generation matrix */
+	uint64_t first_aware;
+	uint64_t last_aware;
+
+	uint32_t physical_damage;
+	uint32_t condi_damage;
+	uint32_t dps;
+	uint32_t boss_physical_damage;
+	uint32_t boss_condi_damage;
+	uint32_t boss_dps;
+
+	uint32_t damage_taken;
+	uint32_t barrier_absorbed;
+	uint32_t downs;
+	uint32_t deaths;
+	uint32_t blocked;
+	uint32_t evaded;
+	uint32_t invulned;
+	uint32_t missed;
+
+	uint64_t buffs; /* float[buff_count], average stacks */
+	uint64_t casts; /* revtc_cast[cast_count] */
+	uint64_t damage_taken_by_skill; /* revtc_damage_taken[damage_taken_count] */
+	uint32_t cast_count;
+	uint32_t damage_taken_count;
+} revtc_player;
+
+typedef struct revtc_parser revtc_parser;
+
+/* Parses one log into a new block, NULL only if the block cannot be allocated. Invalid logs still return a
+ * block, with valid = 0 and the error string set. */
+const revtc_header* revtc_parse(const uint8_t* data, size_t len);
+
+/* Long-lived parser that keeps its containers between logs, cheaper for many small logs. threads is the
+ * number of threads per parse, 0 or 1 runs on the calling thread. */
+revtc_parser* revtc_parser_new(unsigned threads);
+const revtc_header* revtc_parser_parse(revtc_parser* parser, const uint8_t* data, size_t len);
+void revtc_parser_free(revtc_parser* parser);
+
+void revtc_free(const revtc_header* result);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,457 @@
+#include "RevtcColumnar.h"
+#include <algorithm>
+#include <cstring>
+
+namespace Revtc {
+
+    static const char columnar_magic[8] = { 'R', 'V', 'T', 'C', 'C', 'O', 'L', '\0' };
+
+    //Byte width of each CombatEvent field in declaration order
+    static const uint8_t field_widths[COLUMNAR_FIELD_COUNT] = {
+        8, 8, 8, 4, 4, 4, 4, // time .. skillid
+        2, 2, 2, 2, // instance ids
+        1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, // iff .. is_offcycle
+        4, // buff_instid
+    };
+
+    static uint64_t getField(const CombatEvent& event, uint32_t field)
+    {
+        switch (field) {
+            case 0: return event.time;
+            case 1: return event.src_agent;
+            case 2: return event.dst_agent;
+            case 3: return (uint32_t)event.value;
+            case 4: return (uint32_t)event.buff_dmg;
+            case 5: return event.overstack_value;
+            case 6: return event.skillid;
+            case 7: return event.src_instid;
+            case 8: return event.dst_instid;
+            case 9: return event.src_master_instid;
+            case 10: return event.dst_master_instid;
+            case 11: return event.iff;
+            case 12: return event.buff;
+            case 13: return event.result;
+            case 14: return event.is_activation;
+            case 15: return event.is_buffremove;
+            case 16: return event.is_ninety;
+            case 17: return event.is_fifty;
+            case 18: return event.is_moving;
+            case 19: return event.is_statechange;
+            case 20: return event.is_flanking;
+            case 21: return event.is_shields;
+            case 22: return event.is_offcycle;
+            default: return event.buff_instid;
+        }
+    }
+
+    static void setField(CombatEvent& event, uint32_t field, uint64_t v)
+    {
+        switch (field) {
+            case 0: event.time = v; break;
+            case 1: event.src_agent = v; break;
+            case 2: event.dst_agent = v; break;
+            case 3: event.value = (int32_t)(uint32_t)v; break;
+            case 4: event.buff_dmg = (int32_t)(uint32_t)v; break;
+            case 5: event.overstack_value = (uint32_t)v; break;
+            case 6: event.skillid = (uint32_t)v; break;
+            case 7: event.src_instid = (uint16_t)v; break;
+            case 8: event.dst_instid = (uint16_t)v; break;
+            case 9: event.src_master_instid = (uint16_t)v; break;
+            case 10: event.dst_master_instid = (uint16_t)v; break;
+            case 11: event.iff = (uint8_t)v; break;
+            case 12: event.buff = (uint8_t)v; break;
+            case 13: event.result = (uint8_t)v; break;
+            case 14: event.is_activation = (uint8_t)v; break;
+            case 15: event.is_buffremove = (uint8_t)v; break;
+            case 16: event.is_ninety = (uint8_t)v; break;
+            case 17: event.is_fifty = (uint8_t)v; break;
+            case 18: event.is_moving = (uint8_t)v; break;
+            case 19: event.is_statechange = (uint8_t)v; break;
+            case 20: event.is_flanking = (uint8_t)v; break;
+            case 21: event.is_shields = (uint8_t)v; break;
+            case 22: event.is_offcycle = (uint8_t)v; break;
+            default: event.buff_instid = (uint32_t)v; break;
+        }
+    }
+
+    static void putVarint(std::vector<uint8_t>& out, uint64_t v)
+    {
+        while (v >= 0x80) {
+            out.push_back((uint8_t)(v | 0x80));
+            v >>= 7;
+        }
+        out.push_back((uint8_t)v);
+    }
+
+    static bool getVarint(const uint8_t*& p, const uint8_t* end, uint64_t& v)
+    {
+        v = 0;
+        for (unsigned shift = 0; p < end && shift < 64; shift += 7) {
+            uint8_t byte = *p++;
+            v |= (uint64_t)(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    static bool writeFile(void* context, const void* data, size_t len)
+    {
+        return fwrite(data, 1, len, (std::FILE*)context) == len;
+    }
+
+    ColumnarWriter::ColumnarWriter(SinkFn sink, void* context, const ColumnarOptions& options)
+            : sink(sink)
+            , context(context)
+            , options(options)
+            , good(true)
+    {
+        if (!this->options.block_rows) {
+            this->options.block_rows = 1;
+        }
+    }
+
+    ColumnarWriter::ColumnarWriter(std::FILE* file, const ColumnarOptions& options)
+            : ColumnarWriter(writeFile, file, options)
+    {
+    }
+
+    bool ColumnarWriter::put(const void* data, size_t len)
+    {
+        if (good && !sink(context, data, len)) {
+            good = false;
+        }
+        return good;
+    }
+
+    bool ColumnarWriter::begin(const Parser& parser)
+    {
+        put(columnar_magic, sizeof(columnar_magic));
+        put(&COLUMNAR_VERSION, sizeof(uint32_t));
+        put(&options.block_rows, sizeof(uint32_t));
+
+        //Agent dictionary sorted by address so the same log always produces the same file
+        std::vector<const Agent*> sorted;
+        sorted.reserve(parser.agents.size());
+        for (const auto& agent_pair : parser.agents) {
+            sorted.push_back(&agent_pair.second);
+        }
+        std::sort(sorted.begin(), sorted.end(), [](const Agent* lhs, const Agent* rhs) { return lhs->addr < rhs->addr; });
+
+        agent_index.clear();
+        uint32_t agent_count = (uint32_t)sorted.size();
+        put(&agent_count, sizeof(agent_count));
+        for (const Agent* agent : sorted) {
+            agent_index.emplace(agent->addr, (uint32_t)agent_index.size());
+            uint16_t name_len = (uint16_t)std::min<size_t>(agent->name.size(), UINT16_MAX);
+            put(&agent->addr, sizeof(agent->addr));
+            put(&agent->prof, sizeof(agent->prof));
+            put(&agent->is_elite, sizeof(agent->is_elite));
+            put(&name_len, sizeof(name_len));
+            put(agent->name.data(), name_len);
+        }
+
+        std::vector<const Skill*> skills;
+        skills.reserve(parser.skills.size());
+        for (const auto& skill_pair : parser.skills) {
+            skills.push_back(&skill_pair.second);
+        }
+        std::sort(skills.begin(), skills.end(), [](const Skill* lhs, const Skill* rhs) { return lhs->id < rhs->id; });
+
+        uint32_t skill_count = (uint32_t)skills.size();
+        put(&skill_count, sizeof(skill_count));
+        for (const Skill* skill : skills) {
+            uint16_t name_len = (uint16_t)std::min<size_t>(skill->name.size(), UINT16_MAX);
+            put(&skill->id, sizeof(skill->id));
+            put(&name_len, sizeof(name_len));
+            put(skill->name.data(), name_len);
+        }
+
+        block.clear();
+        block.reserve(options.block_rows);
+        return good;
+    }
+
+    bool ColumnarWriter::append(const CombatEvent& event)
+    {
+        block.push_back(event);
+        if (block.size() >= options.block_rows) {
+            return flushBlock();
+        }
+        return good;
+    }
+
+    bool ColumnarWriter::finish()
+    {
+        if (!block.empty()) {
+            flushBlock();
+        }
+        uint32_t end = 0;
+        return put(&end, sizeof(end));
+    }
+
+    bool ColumnarWriter::flushBlock()
+    {
+        uint32_t rows = (uint32_t)block.size();
+        put(&rows, sizeof(rows));
+        for (uint32_t field = 0; field < COLUMNAR_FIELD_COUNT; ++field) {
+            ColumnEncoding encoding = ColumnEncoding::RAW;
+            if (options.encode) {
+                if (field == 0) {
+                    encoding = ColumnEncoding::DELTA;
+                }
+                else if (field == 1 || field == 2) {
+                    encoding = ColumnEncoding::DICT;
+                }
+            }
+
+            column.clear();
+            if (encoding == ColumnEncoding::DELTA) {
+                uint64_t previous = 0;
+                for (const CombatEvent& event : block) {
+                    uint64_t current = getField(event, field);
+                    int64_t delta = (int64_t)(current - previous);
+                    putVarint(column, ((uint64_t)delta << 1) ^ (uint64_t)(delta >> 63));
+                    previous = current;
+                }
+            }
+            else if (encoding == ColumnEncoding::DICT) {
+                exceptions.clear();
+                for (const CombatEvent& event : block) {
+                    uint64_t addr = getField(event, field);
+                    auto it = agent_index.find(addr);
+                    if (it != agent_index.end()) {
+                        putVarint(column, (uint64_t)it->second + 1);
+                    }
+                    else {
+                        putVarint(column, 0);
+                        exceptions.push_back(addr);
+                    }
+                }
+                uint32_t exception_count = (uint32_t)exceptions.size();
+                size_t offset = column.size();
+                column.resize(offset + sizeof(uint32_t) + exceptions.size() * sizeof(uint64_t));
+                memcpy(&column[offset], &exception_count, sizeof(uint32_t));
+                if (exception_count) {
+                    memcpy(&column[offset + sizeof(uint32_t)], exceptions.data(), exceptions.size() * sizeof(uint64_t));
+                }
+            }
+            else {
+                uint8_t width = field_widths[field];
+                column.resize((size_t)rows * width);
+                uint8_t* out = column.data();
+                for (const CombatEvent& event : block) {
+                    uint64_t v = getField(event, field);
+                    memcpy(out, &v, width);
+                    out += width;
+                }
+            }
+
+            uint8_t encoding_byte = (uint8_t)encoding;
+            uint32_t column_len = (uint32_t)column.size();
+            put(&encoding_byte, sizeof(encoding_byte));
+            put(&column_len, sizeof(column_len));
+            put(column.data(), column.size());
+        }
+        block.clear();
+        return good;
+    }
+
+    ColumnarReader::ColumnarReader(std::FILE* file)
+            : version(0)
+            , block_rows(0)
+            , file(file)
+            , good(true)
+            , remaining(UINT64_MAX)
+    {
+    }
+
+    bool ColumnarReader::get(void* data, size_t len)
+    {
+        if (good && (len > remaining || fread(data, 1, len, file) != len)) {
+            good = false;
+        }
+        if (good && remaining != UINT64_MAX) {
+            remaining -= len;
+        }
+        return good;
+    }
+
+    bool ColumnarReader::begin()
+    {
+        //Bytes left in a seekable file bound the column lengths, pipes go unbounded
+        remaining = UINT64_MAX;
+        long start = ftell(file);
+        if (start >= 0 && fseek(file, 0, SEEK_END) == 0) {
+            long size = ftell(file);
+            if (fseek(file, start, SEEK_SET) != 0) {
+                good = false;
+                return false;
+            }
+            if (size >= start) {
+                remaining = (uint64_t)(size - start);
+            }
+        }
+
+        char magic[sizeof(columnar_magic)];
+        if (!get(magic, sizeof(magic)) || memcmp(magic, columnar_magic, sizeof(magic)) != 0) {
+            good = false;
+            return false;
+        }
+        get(&version, sizeof(version));
+        get(&block_rows, sizeof(block_rows));
+        if (!good || version != COLUMNAR_VERSION) {
+            good = false;
+            return false;
+        }
+
+        uint32_t agent_count = 0;
+        get(&agent_count, sizeof(agent_count));
+        agents.clear();
+        for (uint32_t i = 0; good && i < agent_count; ++i) {
+            ColumnarAgent agent;
+            uint16_t name_len = 0;
+            get(&agent.addr, sizeof(agent.addr));
+            get(&agent.prof, sizeof(agent.prof));
+            get(&agent.is_elite, sizeof(agent.is_elite));
+            get(&name_len, sizeof(name_len));
+            agent.name.resize(name_len);
+            get(&agent.name[0], name_len);
+            agents.push_back(std::move(agent));
+        }
+
+        uint32_t skill_count = 0;
+        get(&skill_count, sizeof(skill_count));
+        skills.clear();
+        for (uint32_t i = 0; good && i < skill_count; ++i) {
+            Skill skill;
+            skill.index = i;
+            uint16_t name_len = 0;
+            get(&skill.id, sizeof(skill.id));
+            get(&name_len, sizeof(name_len));
+            skill.name.resize(name_len);
+            get(&skill.name[0], name_len);
+            skills.push_back(std::move(skill));
+        }
+        return good;
+    }
+
+    bool ColumnarReader::next(std::vector<CombatEvent>& events)
+    {
+        events.clear();
+        uint32_t rows = 0;
+        if (!get(&rows, sizeof(rows)) || rows == 0) {
+            return false;
+        }
+        if (rows > block_rows) {
+            good = false;
+            return false;
+        }
+        //No encoding takes more than a 10 byte varint per row, DICT adds its u32 exception count
+        const uint64_t max_column_len = (uint64_t)rows * 10 + sizeof(uint32_t);
+        events.resize(rows);
+        for (uint32_t field = 0; good && field < COLUMNAR_FIELD_COUNT; ++field) {
+            uint8_t encoding = 0;
+            uint32_t column_len = 0;
+            get(&encoding, sizeof(encoding));
+            get(&column_len, sizeof(column_len));
+            if (!good || column_len > max_column_len || column_len > remaining) {
+                good = false;
+                break;
+            }
+            column.resize(column_len);
+            if (column_len) {
+                get(column.data(), column_len);
+            }
+            if (good && !decodeColumn(field, (ColumnEncoding)encoding, events)) {
+                good = false;
+            }
+        }
+        return good;
+    }
+
+    bool ColumnarReader::decodeColumn(uint32_t field, ColumnEncoding encoding, std::vector<CombatEvent>& events)
+    {
+        const uint8_t* p = column.data();
+        const uint8_t* end = p + column.size();
+        if (encoding == ColumnEncoding::RAW) {
+            uint8_t width = field_widths[field];
+            if (column.size() != events.size() * width) {
+                return false;
+            }
+            for (CombatEvent& event : events) {
+                uint64_t v = 0;
+                memcpy(&v, p, width);
+                setField(event, field, v);
+                p += width;
+            }
+        }
+        else if (encoding == ColumnEncoding::DELTA) {
+            uint64_t previous = 0;
+            for (CombatEvent& event : events) {
+                uint64_t zigzag;
+                if (!getVarint(p, end, zigzag)) {
+                    return false;
+                }
+                int64_t delta = (int64_t)(zigzag >> 1) ^ -(int64_t)(zigzag & 1);
+                previous += (uint64_t)delta;
+                setField(event, field, previous);
+            }
+        }
+        else if (encoding == ColumnEncoding::DICT) {
+            //Indices first, the exception list follows them
+            const uint8_t* indices = p;
+            for (size_t i = 0; i < events.size(); ++i) {
+                uint64_t index;
+                if (!getVarint(p, end, index)) {
+                    return false;
+                }
+            }
+            uint32_t exception_count = 0;
+            if ((size_t)(end - p) < sizeof(uint32_t)) {
+                return false;
+            }
+            memcpy(&exception_count, p, sizeof(uint32_t));
+            const uint8_t* exception = p + sizeof(uint32_t);
+            if ((size_t)(end - exception) != (size_t)exception_count * sizeof(uint64_t)) {
+                return false;
+            }
+            p = indices;
+            for (CombatEvent& event : events) {
+                uint64_t index;
+                getVarint(p, end, index);
+                uint64_t addr;
+                if (index) {
+                    if (index > agents.size()) {
+                        return false;
+                    }
+                    addr = agents[index - 1].addr;
+                }
+                else {
+                    if (!exception_count--) {
+                        return false;
+                    }
+                    memcpy(&addr, exception, sizeof(uint64_t));
+                    exception += sizeof(uint64_t);
+                }
+                setField(event, field, addr);
+            }
+        }
+        else {
+            return false;
+        }
+        return true;
+    }
+
+    bool writeColumnar(const Parser& parser, std::FILE* file, const ColumnarOptions& options)
+    {
+        ColumnarWriter writer(file, options);
+        writer.begin(parser);
+        for (const CombatEvent& event : parser.events) {
+            writer.append(event);
+        }
+        return writer.finish();
+    }
+
+}
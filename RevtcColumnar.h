@@ -0,0 +1,96 @@
+#pragma once
+
+#include "Revtc.h"
+#include <cstdio>
+
+namespace Revtc {
+
+	//Columnar event file:
+	//  header   "RVTCCOL\0", u32 version, u32 rows per block
+	//  agents   u32 count, then u64 addr, u32 prof, u32 is_elite, u16 name length, name
+	//  skills   u32 count, then i32 id, u16 name length, name
+	//  blocks   u32 rows (0 ends the file), then one column per CombatEvent field in declaration order,
+	//           each as u8 encoding, u32 byte length, bytes
+	//Integers and RAW column values are copied in host byte order, which is little-endian on every platform
+	//the EVTC reader supports. Files are not portable to a big-endian host.
+	const uint32_t COLUMNAR_VERSION = 1;
+	const uint32_t COLUMNAR_FIELD_COUNT = 24;
+
+	enum class ColumnEncoding : uint8_t {
+		RAW,   // fixed width values
+		DELTA, // zigzag varint of the difference to the previous row, first row against 0
+		DICT,  // varint agent table index + 1, 0 means the next u64 of the trailing exception list
+	};
+
+	struct ColumnarOptions {
+		uint32_t block_rows = 64 * 1024;
+		bool encode = true; // false writes every column RAW
+	};
+
+	struct ColumnarAgent {
+		uint64_t addr;
+		uint32_t prof;
+		uint32_t is_elite;
+		std::string name;
+	};
+
+	class ColumnarWriter
+	{
+	public:
+		typedef bool (*SinkFn)(void* context, const void* data, size_t len);
+
+		ColumnarWriter(SinkFn sink, void* context, const ColumnarOptions& options = ColumnarOptions());
+		explicit ColumnarWriter(std::FILE* file, const ColumnarOptions& options = ColumnarOptions());
+
+		//Writes the header and dictionaries, must come first
+		bool begin(const Parser& parser);
+		bool append(const CombatEvent& event);
+		bool finish();
+
+		bool ok() const { return good; }
+
+	private:
+		SinkFn sink;
+		void* context;
+		ColumnarOptions options;
+		bool good;
+		std::unordered_map<uint64_t, uint32_t> agent_index;
+		std::vector<CombatEvent> block;
+		std::vector<uint8_t> column;
+		std::vector<uint64_t> exceptions;
+
+		bool put(const void* data, size_t len);
+		bool flushBlock();
+		void encodeColumn(uint32_t field);
+	};
+
+	class ColumnarReader
+	{
+	public:
+		explicit ColumnarReader(std::FILE* file);
+
+		//Reads the header and dictionaries, must come first
+		bool begin();
+		//Decodes the next block into events (cleared first), returns false at the end of the file or on error
+		bool next(std::vector<CombatEvent>& events);
+
+		bool ok() const { return good; }
+
+		uint32_t version;
+		uint32_t block_rows;
+		std::vector<ColumnarAgent> agents;
+		std::vector<Skill> skills;
+
+	private:
+		std::FILE* file;
+		bool good;
+		std::vector<uint8_t> column;
+		uint64_t remaining; // bytes left in the file, UINT64_MAX when it cannot seek
+
+		bool get(void* data, size_t len);
+		bool decodeColumn(uint32_t field, ColumnEncoding encoding, std::vector<CombatEvent>& events);
+	};
+
+	bool writeColumnar(const Parser& parser, std::FILE* file, const ColumnarOptions& options = ColumnarOptions());
+
+}
@@ -0,0 +1,193 @@
+#include "RevtcFingerprint.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+
+namespace Revtc {
+
+    static uint64_t hashBytes(const char* data, size_t len)
+    {
+        //FNV-1a
+        uint64_t h = 0xcbf29ce484222325ull;
+        for (size_t i = 0; i < len; ++i) {
+            h ^= (uint8_t)data[i];
+            h *= 0x100000001b3ull;
+        }
+        return h;
+    }
+
+    static uint64_t mix(uint64_t h, uint64_t v)
+    {
+        h ^= v + 0x9E3779B97F4A7C15ull + (h << 6) + (h >> 2);
+        h ^= h >> 31;
+        h *= 0xBF58476D1CE4E5B9ull;
+        h ^= h >> 27;
+        return h;
+    }
+
+    template<typename T>
+    static T load(const unsigned char* p)
+    {
+        T v;
+        memcpy(&v, p, sizeof(T));
+        return v;
+    }
+
+    //Keeps the smallest distinct hashes seen, i.e. a uniform sample of the distinct hits
+    static void sample(Fingerprint& fp, uint64_t h)
+    {
+        uint64_t* end = fp.samples + fp.sample_count;
+        if (fp.sample_count == FINGERPRINT_SAMPLES && h >= end[-1]) return;
+        uint64_t* it = std::lower_bound(fp.samples, end, h);
+        if (it != end && *it == h) return;
+        if (fp.sample_count < FINGERPRINT_SAMPLES) {
+            ++fp.sample_count;
+            ++end;
+        }
+        std::copy_backward(it, end - 1, end);
+        *it = h;
+    }
+
+    uint64_t Fingerprint::key(int32_t bucket_offset) const
+    {
+        uint64_t h = mix(area_id, roster);
+        return mix(h, (uint64_t)((int64_t)(server_start / FINGERPRINT_WINDOW) + bucket_offset));
+    }
+
+    float Fingerprint::overlap(const Fingerprint& other) const
+    {
+        if (sample_count == 0 || other.sample_count == 0) return 0.0f;
+        //Merge the two bottom-k sets and count how many of the k smallest of the union sit in both
+        uint32_t k = std::min(sample_count, other.sample_count);
+        uint32_t i = 0, j = 0, taken = 0, shared = 0;
+        while (taken < k && i < sample_count && j < other.sample_count) {
+            if (samples[i] == other.samples[j]) {
+                ++shared;
+                ++i;
+                ++j;
+            } else if (samples[i] < other.samples[j]) {
+                ++i;
+            } else {
+                ++j;
+            }
+            ++taken;
+        }
+        return (float)shared / k;
+    }
+
+    bool Fingerprint::matches(const Fingerprint& other, uint32_t max_skew, float min_overlap) const
+    {
+        if (!valid || !other.valid) return false;
+        if (area_id != other.area_id || roster != other.roster) return false;
+        uint32_t skew = server_start > other.server_start ? server_start - other.server_start : other.server_start - server_start;
+        if (skew > max_skew) return false;
+        if (sample_count == 0 || other.sample_count == 0) return sample_count == other.sample_count;
+        return overlap(other) >= min_overlap;
+    }
+
+    Fingerprint fingerprint(const unsigned char* buf, size_t len)
+    {
+        Fingerprint fp;
+        memset(&fp, 0, sizeof(fp));
+
+        if (len < 20 || memcmp(buf, "EVTC", 4) != 0) return fp;
+        uint8_t revision = buf[12];
+        fp.area_id = load<uint16_t>(buf + 13);
+
+        //Agents: players by address for the hit sample, the roster, and the boss addresses
+        std::vector<std::pair<uint64_t, uint64_t>> accounts; // addr, account hash
+        std::vector<uint64_t> bosses;
+        uint32_t agent_count = load<uint32_t>(buf + 16);
+        size_t index = 20;
+        if (agent_count > (len - index) / 96) return fp;
+        for (uint32_t i = 0; i < agent_count; ++i, index += 96) {
+            uint64_t addr = load<uint64_t>(buf + index);
+            uint32_t prof = load<uint32_t>(buf + index + 8);
+            uint32_t is_elite = load<uint32_t>(buf + index + 12);
+            if (is_elite != 0xFFFFFFFF) {
+                //Character name, then ":account"
+                const char* name = (const char*)buf + index + 28;
+                size_t name_len = strnlen(name, 64);
+                if (name_len + 2 >= 64) continue;
+                const char* account = name + name_len + 2;
+                size_t account_len = strnlen(account, 64 - name_len - 2);
+                accounts.emplace_back(addr, hashBytes(account, account_len));
+            } else if ((prof >> 16) != 0xFFFF && (uint16_t)prof == fp.area_id) {
+                bosses.push_back(addr);
+            }
+        }
+        std::sort(accounts.begin(), accounts.end());
+
+        std::vector<uint64_t> roster;
+        roster.reserve(accounts.size());
+        for (const auto& account : accounts) roster.push_back(account.second);
+        std::sort(roster.begin(), roster.end());
+        roster.erase(std::unique(roster.begin(), roster.end()), roster.end());
+        fp.roster = 0;
+        for (uint64_t h : roster) fp.roster = mix(fp.roster, h);
+        fp.player_count = (uint32_t)roster.size();
+
+        //Skills
+        if (len - index < 4) return fp;
+        uint32_t skill_count = load<uint32_t>(buf + index);
+        index += 4;
+        if (skill_count > (len - index) / 68) return fp;
+        index += (size_t)skill_count * 68;
+
+        //Events, read field by field so neither layout needs to be decoded in full
+        size_t stride = revision == 0 ? sizeof(CombatEventRev0) : sizeof(CombatEvent);
+        size_t off_src, off_dst, off_value, off_skill, off_buff, off_activation, off_buffremove, off_statechange;
+        if (revision == 0) {
+            off_src = offsetof(CombatEventRev0, src_agent);
+            off_dst = offsetof(CombatEventRev0, dst_agent);
+            off_value = offsetof(CombatEventRev0, value);
+            off_skill = offsetof(CombatEventRev0, skillid);
+            off_buff = offsetof(CombatEventRev0, buff);
+            off_activation = offsetof(CombatEventRev0, is_activation);
+            off_buffremove = offsetof(CombatEventRev0, is_buffremove);
+            off_statechange = offsetof(CombatEventRev0, is_statechange);
+        } else {
+            off_src = offsetof(CombatEvent, src_agent);
+            off_dst = offsetof(CombatEvent, dst_agent);
+            off_value = offsetof(CombatEvent, value);
+            off_skill = offsetof(CombatEvent, skillid);
+            off_buff = offsetof(CombatEvent, buff);
+            off_activation = offsetof(CombatEvent, is_activation);
+            off_buffremove = offsetof(CombatEvent, is_buffremove);
+            off_statechange = offsetof(CombatEvent, is_statechange);
+        }
+
+        //Each direct hit is sampled on its own, by account, skill and damage, so the sample does not depend on
+        //the order a POV recorded the hits in. Condition ticks repeat the same damage every second and would
+        //match other fights of the same squad, they are left out. Only the first FINGERPRINT_SCAN_EVENTS
+        //events are read: POVs of one fight start logging together, so their prefixes share most hits.
+        size_t event_count = std::min((len - index) / stride, (size_t)FINGERPRINT_SCAN_EVENTS);
+        const unsigned char* event = buf + index;
+        for (size_t i = 0; i < event_count; ++i, event += stride) {
+            uint8_t statechange = event[off_statechange];
+            if (statechange) {
+                if (statechange == CBTS_LOGSTART && fp.server_start == 0) {
+                    fp.server_start = load<uint32_t>(event + off_value);
+                }
+                continue;
+            }
+            if (event[off_activation] || event[off_buffremove] || event[off_buff]) continue;
+
+            int32_t damage = load<int32_t>(event + off_value);
+            if (damage <= 0) continue;
+
+            uint64_t dst = load<uint64_t>(event + off_dst);
+            if (std::find(bosses.begin(), bosses.end(), dst) == bosses.end()) continue;
+            uint64_t src = load<uint64_t>(event + off_src);
+            auto it = std::lower_bound(accounts.begin(), accounts.end(), std::make_pair(src, (uint64_t)0));
+            if (it == accounts.end() || it->first != src) continue;
+
+            uint32_t skillid = revision == 0 ? load<uint16_t>(event + off_skill) : load<uint32_t>(event + off_skill);
+            sample(fp, mix(mix(it->second, skillid), (uint32_t)damage));
+        }
+
+        fp.valid = true;
+        return fp;
+    }
+
+}
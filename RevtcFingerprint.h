@@ -0,0 +1,38 @@
+#pragma once
+
+#include "Revtc.h"
+
+namespace Revtc {
+
+	const uint32_t FINGERPRINT_SAMPLES = 16;
+	const uint32_t FINGERPRINT_WINDOW = 120; // seconds of LOGSTART server time per key bucket
+	const uint32_t FINGERPRINT_SCAN_EVENTS = 1 << 16; // events read for the hit sample, 4 MB of a revision 1 log
+
+	//Identity of an encounter that stays the same across the POVs uploaded by different squad members.
+	//Only POV-independent data goes in: the boss, the squad's account names, the server timestamp at
+	//log start and a sample of player direct hits on the boss (skill, damage, account), never local times,
+	//agent addresses or the arcdps build.
+	struct Fingerprint {
+		bool valid;
+		uint16_t area_id;
+		uint32_t server_start;  // CBTS_LOGSTART server unix timestamp, 0 if the log has none
+		uint64_t roster;        // hash of the sorted account names
+		uint32_t player_count;
+		uint32_t sample_count;
+		uint64_t samples[FINGERPRINT_SAMPLES]; // smallest hit hashes, ascending
+
+		//Bucket key for hash maps. POVs started on either side of a bucket edge land in neighbouring
+		//buckets, so probe key(-1) and key(1) as well before treating a log as new.
+		uint64_t key(int32_t bucket_offset = 0) const;
+		//Same boss and roster, log starts at most max_skew seconds apart, and (when both logs have hits
+		//on the boss) at least min_overlap of the damage samples shared
+		bool matches(const Fingerprint& other, uint32_t max_skew = FINGERPRINT_WINDOW, float min_overlap = 0.25f) const;
+		//Fraction of samples shared with other, 0 if either has none
+		float overlap(const Fingerprint& other) const;
+	};
+
+	//Reads the header, agent table and the first FINGERPRINT_SCAN_EVENTS raw events without building any
+	//Parser state, cheap enough to run before deciding whether a log needs a full parse
+	Fingerprint fingerprint(const unsigned char* buf, size_t len);
+
+}
@@ -0,0 +1,522 @@
+#include "RevtcJson.h"
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace Revtc {
+
+    static const char* event_fields[] = {
+        "time", "src_agent", "dst_agent", "value", "buff_dmg", "overstack_value", "skillid",
+        "src_instid", "dst_instid", "src_master_instid", "dst_master_instid",
+        "iff", "buff", "result", "is_activation", "is_buffremove", "is_ninety", "is_fifty", "is_moving",
+        "is_statechange", "is_flanking", "is_shields", "is_offcycle", "buff_instid",
+    };
+
+    static const char* cast_outcomes[] = { "unfinished", "completed", "fired", "cancelled" };
+
+    static bool writeFd(void* context, const char* data, size_t len)
+    {
+        int fd = *(int*)context;
+        while (len) {
+#ifdef _WIN32
+            int written = _write(fd, data, (unsigned int)len);
+#else
+            ssize_t written = ::write(fd, data, len);
+#endif
+            if (written <= 0) {
+                return false;
+            }
+            data += written;
+            len -= (size_t)written;
+        }
+        return true;
+    }
+
+    JsonWriter::JsonWriter(char* buf, size_t cap, FlushFn flush, void* context)
+            : buf(buf)
+            , cap(cap)
+            , used(0)
+            , total(0)
+            , good(true)
+            , first(true)
+            , flush_fn(flush)
+            , context(context)
+            , fd(-1)
+    {
+    }
+
+    JsonWriter::JsonWriter(int fd, char* buf, size_t cap)
+            : JsonWriter(buf, cap, writeFd, nullptr)
+    {
+        this->fd = fd;
+        this->context = &this->fd;
+    }
+
+    bool JsonWriter::flush()
+    {
+        if (flush_fn && used) {
+            if (!flush_fn(context, buf, used)) {
+                good = false;
+            }
+            used = 0;
+        }
+        return good;
+    }
+
+    bool JsonWriter::finish()
+    {
+        return flush();
+    }
+
+    void JsonWriter::raw(const char* data, size_t len)
+    {
+        total += len;
+        while (len) {
+            if (used == cap) {
+                if (!flush_fn || !flush()) {
+                    good = false;
+                    return;
+                }
+            }
+            size_t chunk = std::min(len, cap - used);
+            memcpy(buf + used, data, chunk);
+            used += chunk;
+            data += chunk;
+            len -= chunk;
+        }
+    }
+
+    void JsonWriter::raw(char c)
+    {
+        raw(&c, 1);
+    }
+
+    void JsonWriter::separator()
+    {
+        if (!first) {
+            raw(',');
+        }
+        first = false;
+    }
+
+    void JsonWriter::beginObject()
+    {
+        raw('{');
+        first = true;
+    }
+
+    void JsonWriter::endObject()
+    {
+        raw('}');
+        first = false;
+    }
+
+    void JsonWriter::beginArray()
+    {
+        raw('[');
+        first = true;
+    }
+
+    void JsonWriter::endArray()
+    {
+        raw(']');
+        first = false;
+    }
+
+    void JsonWriter::key(const char* name)
+    {
+        separator();
+        raw('"');
+        raw(name, strlen(name));
+        raw("\":", 2);
+    }
+
+    //Length of the well-formed UTF-8 sequence starting at s, or 0 with skip set to the bytes of its longest
+    //ill-formed prefix, which are replaced as one U+FFFD (the Unicode "maximal subpart" practice)
+    static size_t utf8Length(const unsigned char* s, size_t n, size_t& skip)
+    {
+        size_t need;
+        unsigned char low = 0x80;
+        unsigned char high = 0xBF;
+        if (s[0] >= 0xC2 && s[0] <= 0xDF) {
+            need = 2;
+        }
+        else if (s[0] >= 0xE0 && s[0] <= 0xEF) {
+            need = 3;
+            if (s[0] == 0xE0) low = 0xA0;       // overlong
+            else if (s[0] == 0xED) high = 0x9F; // surrogates
+        }
+        else if (s[0] >= 0xF0 && s[0] <= 0xF4) {
+            need = 4;
+            if (s[0] == 0xF0) low = 0x90;       // overlong
+            else if (s[0] == 0xF4) high = 0x8F; // past U+10FFFF
+        }
+        else {
+            skip = 1;
+            return 0;
+        }
+        size_t i = 1;
+        for (; i < need && i < n; ++i) {
+            if (s[i] < low || s[i] > high) {
+                break;
+            }
+            low = 0x80;
+            high = 0xBF;
+        }
+        if (i == need) {
+            return need;
+        }
+        skip = i;
+        return 0;
+    }
+
+    void JsonWriter::value(const char* text, size_t len)
+    {
+        static const char hex[] = "0123456789abcdef";
+        raw('"');
+        size_t run = 0;
+        for (size_t i = 0; i < len; ++i) {
+            unsigned char c = (unsigned char)text[i];
+            if (c >= 0x80) {
+                //Names come straight from the log, invalid UTF-8 would make the whole document invalid
+                size_t skip;
+                size_t valid = utf8Length((const unsigned char*)text + i, len - i, skip);
+                if (valid) {
+                    i += valid - 1;
+                    continue;
+                }
+                raw(text + run, i - run);
+                raw("\xEF\xBF\xBD", 3);
+                i += skip - 1;
+                run = i + 1;
+                continue;
+            }
+            if (c >= 0x20 && c != '"' && c != '\\') {
+                continue;
+            }
+            raw(text + run, i - run);
+            run = i + 1;
+            switch (c) {
+                case '"': raw("\\\"", 2); break;
+                case '\\': raw("\\\\", 2); break;
+                case '\n': raw("\\n", 2); break;
+                case '\r': raw("\\r", 2); break;
+                case '\t': raw("\\t", 2); break;
+                default: {
+                    char escaped[6] = { '\\', 'u', '0', '0', hex[c >> 4], hex[c & 0xF] };
+                    raw(escaped, sizeof(escaped));
+                }
+            }
+        }
+        raw(text + run, len - run);
+        raw('"');
+    }
+
+    void JsonWriter::value(const char* text)
+    {
+        value(text, strlen(text));
+    }
+
+    void JsonWriter::value(uint64_t number)
+    {
+        char digits[24];
+        auto result = std::to_chars(digits, digits + sizeof(digits), number);
+        raw(digits, result.ptr - digits);
+    }
+
+    void JsonWriter::value(int64_t number)
+    {
+        char digits[24];
+        auto result = std::to_chars(digits, digits + sizeof(digits), number);
+        raw(digits, result.ptr - digits);
+    }
+
+    void JsonWriter::value(float number)
+    {
+        if (!std::isfinite(number)) {
+            literal("null");
+            return;
+        }
+        char digits[32];
+        auto result = std::to_chars(digits, digits + sizeof(digits), number);
+        raw(digits, result.ptr - digits);
+    }
+
+    void JsonWriter::value(bool flag)
+    {
+        if (flag) {
+            literal("true");
+        }
+        else {
+            literal("false");
+        }
+    }
+
+    void JsonWriter::write(const Log& log, const JsonOptions& options, const Parser* parser)
+    {
+        first = true;
+        beginObject();
+        field("schema", JSON_SCHEMA_VERSION);
+        field("version", log.version);
+        field("revision", log.revision);
+        field("area_id", (uint16_t)log.area_id);
+        field("encounter_name", log.encounter_name);
+        field("valid", log.valid);
+        field("error", log.error);
+
+        key("boss_ids");
+        beginArray();
+        for (uint16_t id : log.boss_ids) {
+            separator();
+            value(id);
+        }
+        endArray();
+
+        field("reward_at", log.reward_at);
+        field("log_start", log.log_start);
+        field("log_end", log.log_end);
+        field("server_start", log.server_start);
+        field("boss_lifetime", log.boss_lifetime);
+        field("boss_death", log.boss_death);
+        field("encounter_duration", log.encounter_duration);
+        field("encounter_duration_ms", log.encounter_duration_ms);
+
+        //Buff index table, player and boss buff arrays are indexed by position
+        key("buffs");
+        beginArray();
+        for (uint16_t i = 0; i < BuffRegistry::count(); ++i) {
+            const BuffDef& def = BuffRegistry::at(i);
+            separator();
+            beginObject();
+            field("id", def.id);
+            field("name", def.name);
+            field("category", def.category == BuffCategory::BOON ? "boon" : "condition");
+            field("stacking", def.stacking == BuffStacking::INTENSITY ? "intensity" : "duration");
+            field("max_stacks", def.max_stacks);
+            endObject();
+        }
+        endArray();
+
+        key("boss_buffs");
+        beginArray();
+        for (float average : log.boss_buffs) {
+            separator();
+            value(average);
+        }
+        endArray();
+
+        key("boss_health");
+        beginArray();
+        for (const HealthTimeline& timeline : log.boss_health) {
+            separator();
+            writeHealth(timeline);
+        }
+        endArray();
+
+        key("players");
+        beginArray();
+        for (const Player& player : log.players) {
+            separator();
+            writePlayer(player, parser);
+        }
+        endArray();
+
+        if (options.generation) {
+            key("generation");
+            beginObject();
+            field("player_count", log.generation.player_count);
+            field("boon_count", log.generation.boon_count);
+            key("ms");
+            beginArray();
+            for (uint32_t ms : log.generation.ms) {
+                separator();
+                value(ms);
+            }
+            endArray();
+            endObject();
+        }
+
+        if (options.events && parser) {
+            key("event_fields");
+            beginArray();
+            for (const char* name : event_fields) {
+                separator();
+                value(name);
+            }
+            endArray();
+
+            key("events");
+            beginArray();
+            for (const CombatEvent& event : parser->events) {
+                separator();
+                writeEvent(event);
+            }
+            endArray();
+        }
+        endObject();
+    }
+
+    void JsonWriter::writePlayer(const Player& player, const Parser* parser)
+    {
+        beginObject();
+        field("addr", player.addr);
+        field("name", player.name);
+        field("account", player.account);
+        field("profession", player.profession);
+        field("profession_name", player.profession_name);
+        field("profession_name_short", player.profession_name_short);
+        field("elite_spec", player.elite_spec);
+        field("elite_spec_name", player.elite_spec_name);
+        field("elite_spec_name_short", player.elite_spec_name_short);
+        field("subgroup", player.subgroup);
+        field("slot", player.slot);
+        field("first_aware", player.first_aware);
+        field("last_aware", player.last_aware);
+
+        key("slaves");
+        beginArray();
+        for (uint64_t slave : player.slaves) {
+            separator();
+            value(slave);
+        }
+        endArray();
+
+        field("physical_damage", player.physical_damage);
+        field("condi_damage", player.condi_damage);
+        field("dps", player.dps);
+        field("boss_physical_damage", player.boss_physical_damage);
+        field("boss_condi_damage", player.boss_condi_damage);
+        field("boss_dps", player.boss_dps);
+
+        key("buffs");
+        beginArray();
+        for (float average : player.buffs) {
+            separator();
+            value(average);
+        }
+        endArray();
+
+        key("casts");
+        beginArray();
+        for (const Cast& cast : player.casts) {
+            separator();
+            beginObject();
+            field("start", cast.start);
+            field("duration", cast.duration);
+            field("skill_id", parser && cast.skill < parser->skill_ids.size() ? parser->skill_ids[cast.skill] : 0);
+            field("outcome", cast_outcomes[(size_t)cast.outcome]);
+            field("quickness", cast.quickness);
+            endObject();
+        }
+        endArray();
+
+        key("defense");
+        beginObject();
+        field("damage_taken", player.defense.damage_taken);
+        field("barrier_absorbed", player.defense.barrier_absorbed);
+        field("downs", player.defense.downs);
+        field("deaths", player.defense.deaths);
+        field("blocked", player.defense.blocked);
+        field("evaded", player.defense.evaded);
+        field("invulned", player.defense.invulned);
+        field("missed", player.defense.missed);
+        endObject();
+
+        key("damage_taken_by_skill");
+        beginArray();
+        for (const SkillDamageTaken& taken : player.damage_taken) {
+            separator();
+            beginObject();
+            field("skill_id", taken.skillid);
+            field("damage", taken.damage);
+            field("barrier", taken.barrier);
+            field("hits", taken.hits);
+            endObject();
+        }
+        endArray();
+
+        field("note", player.note);
+        endObject();
+    }
+
+    //Points are [time, percent * 100] and max health changes [time, value] pairs
+    void JsonWriter::writeHealth(const HealthTimeline& timeline)
+    {
+        beginObject();
+        field("addr", timeline.addr);
+        field("species_id", timeline.species_id);
+        key("points");
+        beginArray();
+        for (const HealthPoint& point : timeline.points) {
+            separator();
+            beginArray();
+            separator(); value(point.time);
+            separator(); value(point.percent);
+            endArray();
+        }
+        endArray();
+        key("max_health");
+        beginArray();
+        for (const MaxHealthPoint& point : timeline.max_health) {
+            separator();
+            beginArray();
+            separator(); value(point.time);
+            separator(); value(point.value);
+            endArray();
+        }
+        endArray();
+        endObject();
+    }
+
+    //Events are arrays in event_fields order to keep large exports compact
+    void JsonWriter::writeEvent(const CombatEvent& event)
+    {
+        beginArray();
+        separator(); value(event.time);
+        separator(); value(event.src_agent);
+        separator(); value(event.dst_agent);
+        separator(); value(event.value);
+        separator(); value(event.buff_dmg);
+        separator(); value(event.overstack_value);
+        separator(); value(event.skillid);
+        separator(); value(event.src_instid);
+        separator(); value(event.dst_instid);
+        separator(); value(event.src_master_instid);
+        separator(); value(event.dst_master_instid);
+        separator(); value(event.iff);
+        separator(); value(event.buff);
+        separator(); value(event.result);
+        separator(); value(event.is_activation);
+        separator(); value(event.is_buffremove);
+        separator(); value(event.is_ninety);
+        separator(); value(event.is_fifty);
+        separator(); value(event.is_moving);
+        separator(); value(event.is_statechange);
+        separator(); value(event.is_flanking);
+        separator(); value(event.is_shields);
+        separator(); value(event.is_offcycle);
+        separator(); value(event.buff_instid);
+        endArray();
+    }
+
+    size_t writeJson(const Log& log, char* buf, size_t cap, const JsonOptions& options, const Parser* parser)
+    {
+        JsonWriter writer(buf, cap);
+        writer.write(log, options, parser);
+        return writer.size();
+    }
+
+    bool writeJson(const Log& log, int fd, const JsonOptions& options, const Parser* parser)
+    {
+        char buf[64 * 1024];
+        JsonWriter writer(fd, buf, sizeof(buf));
+        writer.write(log, options, parser);
+        return writer.finish();
+    }
+
+}
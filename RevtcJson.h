@@ -0,0 +1,81 @@
+#pragma once
+
+#include "Revtc.h"
+
+namespace Revtc {
+
+	//Bumped whenever a field changes meaning or is removed. New fields may be added without a bump.
+	const uint32_t JSON_SCHEMA_VERSION = 1;
+
+	struct JsonOptions {
+		bool generation = true;
+		bool events = false; // needs the Parser that produced the Log
+		//Cast skill ids are also resolved through that Parser, without one they are written as 0
+	};
+
+	//Streaming JSON writer. Output is staged in a caller-supplied buffer and handed to the sink
+	//whenever it fills up, nothing is allocated while writing.
+	class JsonWriter
+	{
+	public:
+		typedef bool (*FlushFn)(void* context, const char* data, size_t len);
+
+		//Without a flush function the buffer is the whole output; on overflow ok() turns false but
+		//size() keeps counting, so the caller learns the capacity it needs.
+		JsonWriter(char* buf, size_t cap, FlushFn flush = nullptr, void* context = nullptr);
+		//Writes to a file descriptor, staging through buf
+		JsonWriter(int fd, char* buf, size_t cap);
+
+		void write(const Log& log, const JsonOptions& options = JsonOptions(), const Parser* parser = nullptr);
+		bool finish();
+
+		bool ok() const { return good; }
+		size_t size() const { return total; }
+
+	private:
+		char* buf;
+		size_t cap;
+		size_t used;
+		size_t total;
+		bool good;
+		bool first;
+		FlushFn flush_fn;
+		void* context;
+		int fd;
+
+		bool flush();
+		void raw(const char* data, size_t len);
+		void raw(char c);
+		template<size_t N> void literal(const char (&text)[N]) { raw(text, N - 1); }
+
+		void beginObject();
+		void endObject();
+		void beginArray();
+		void endArray();
+		void key(const char* name);
+		void separator();
+
+		void value(const char* text, size_t len);
+		void value(const std::string& text) { value(text.data(), text.size()); }
+		void value(const char* text);
+		void value(uint64_t number);
+		void value(int64_t number);
+		void value(uint32_t number) { value((uint64_t)number); }
+		void value(int32_t number) { value((int64_t)number); }
+		void value(uint16_t number) { value((uint64_t)number); }
+		void value(uint8_t number) { value((uint64_t)number); }
+		void value(float number);
+		void value(bool flag);
+
+		template<typename T> void field(const char* name, const T& v) { key(name); value(v); }
+
+		void writePlayer(const Player& player, const Parser* parser);
+		void writeHealth(const HealthTimeline& timeline);
+		void writeEvent(const CombatEvent& event);
+	};
+
+	//Returns the bytes needed; the output is complete only if that is <= cap
+	size_t writeJson(const Log& log, char* buf, size_t cap, const JsonOptions& options = JsonOptions(), const Parser* parser = nullptr);
+	bool writeJson(const Log& log, int fd, const JsonOptions& options = JsonOptions(), const Parser* parser = nullptr);
+
+}
@@ -0,0 +1,364 @@
+#include "RevtcLeaderboard.h"
+
+namespace Revtc {
+
+    static void putVarint(std::vector<uint8_t>& out, uint64_t v)
+    {
+        while (v >= 0x80) {
+            out.push_back((uint8_t)(v | 0x80));
+            v >>= 7;
+        }
+        out.push_back((uint8_t)v);
+    }
+
+    static bool getVarint(const uint8_t*& p, const uint8_t* end, uint64_t& v)
+    {
+        v = 0;
+        for (unsigned shift = 0; shift < 64; shift += 7) {
+            if (p == end) return false;
+            uint8_t byte = *p++;
+            v |= (uint64_t)(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) return true;
+        }
+        return false;
+    }
+
+    bool Board::before(const LeaderboardEntry& lhs, const LeaderboardEntry& rhs)
+    {
+        if (lhs.boss_dps != rhs.boss_dps) return lhs.boss_dps > rhs.boss_dps;
+        if (lhs.log_id != rhs.log_id) return lhs.log_id < rhs.log_id;
+        return lhs.account < rhs.account;
+    }
+
+    uint32_t Board::priorityOf(const LeaderboardEntry& entry)
+    {
+        //splitmix64 finalizer
+        uint64_t x = entry.log_id * 0x9E3779B97F4A7C15ull ^ ((uint64_t)entry.account << 32 | entry.boss_dps);
+        x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+        x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+        return (uint32_t)(x ^ (x >> 31));
+    }
+
+    void Board::insert(const LeaderboardEntry& entry)
+    {
+        uint32_t node = (uint32_t)nodes.size();
+        nodes.push_back(Node{ entry, priorityOf(entry), 1, NIL, NIL });
+        root = insert(root, node);
+    }
+
+    uint32_t Board::insert(uint32_t tree, uint32_t node)
+    {
+        if (tree == NIL) {
+            return node;
+        }
+        if (nodes[node].priority > nodes[tree].priority) {
+            split(tree, nodes[node].entry, nodes[node].left, nodes[node].right);
+            nodes[node].size = 1 + sizeOf(nodes[node].left) + sizeOf(nodes[node].right);
+            return node;
+        }
+        if (before(nodes[node].entry, nodes[tree].entry)) {
+            nodes[tree].left = insert(nodes[tree].left, node);
+        }
+        else {
+            nodes[tree].right = insert(nodes[tree].right, node);
+        }
+        nodes[tree].size++;
+        return tree;
+    }
+
+    //Splits tree into the entries ranked before entry and the rest
+    void Board::split(uint32_t tree, const LeaderboardEntry& entry, uint32_t& left, uint32_t& right)
+    {
+        if (tree == NIL) {
+            left = NIL;
+            right = NIL;
+            return;
+        }
+        Node& node = nodes[tree];
+        if (before(node.entry, entry)) {
+            split(node.right, entry, node.right, right);
+            left = tree;
+        }
+        else {
+            split(node.left, entry, left, node.left);
+            right = tree;
+        }
+        node.size = 1 + sizeOf(node.left) + sizeOf(node.right);
+    }
+
+    size_t Board::rank(uint32_t boss_dps) const
+    {
+        size_t above = 0;
+        for (uint32_t node = root; node != NIL;) {
+            if (nodes[node].entry.boss_dps > boss_dps) {
+                above += sizeOf(nodes[node].left) + 1;
+                node = nodes[node].right;
+            }
+            else {
+                node = nodes[node].left;
+            }
+        }
+        return above + 1;
+    }
+
+    size_t Board::rankOf(const LeaderboardEntry& entry) const
+    {
+        size_t above = 0;
+        for (uint32_t node = root; node != NIL;) {
+            const Node& current = nodes[node];
+            if (before(current.entry, entry)) {
+                above += sizeOf(current.left) + 1;
+                node = current.right;
+            }
+            else if (before(entry, current.entry)) {
+                node = current.left;
+            }
+            else {
+                return above + sizeOf(current.left) + 1;
+            }
+        }
+        return 0;
+    }
+
+    const LeaderboardEntry& Board::at(size_t rank) const
+    {
+        uint32_t node = root;
+        for (;;) {
+            size_t left = sizeOf(nodes[node].left);
+            if (rank <= left) {
+                node = nodes[node].left;
+            }
+            else if (rank == left + 1) {
+                return nodes[node].entry;
+            }
+            else {
+                rank -= left + 1;
+                node = nodes[node].right;
+            }
+        }
+    }
+
+    void Board::top(size_t k, std::vector<LeaderboardEntry>& out) const
+    {
+        out.clear();
+        std::vector<uint32_t> path;
+        uint32_t node = root;
+        while (out.size() < k && (node != NIL || !path.empty())) {
+            while (node != NIL) {
+                path.push_back(node);
+                node = nodes[node].left;
+            }
+            node = path.back();
+            path.pop_back();
+            out.push_back(nodes[node].entry);
+            node = nodes[node].right;
+        }
+    }
+
+    uint32_t Board::countSizes(uint32_t node)
+    {
+        if (node == NIL) {
+            return 0;
+        }
+        nodes[node].size = 1 + countSizes(nodes[node].left) + countSizes(nodes[node].right);
+        return nodes[node].size;
+    }
+
+    bool Board::valid() const
+    {
+        uint32_t count = 0;
+        return valid(root, nullptr, nullptr, count) && count == nodes.size();
+    }
+
+    //Entries of the subtree must rank after low and before high, when given
+    bool Board::valid(uint32_t node, const LeaderboardEntry* low, const LeaderboardEntry* high, uint32_t& count) const
+    {
+        if (node == NIL) {
+            return true;
+        }
+        const Node& current = nodes[node];
+        if ((low && !before(*low, current.entry)) || (high && !before(current.entry, *high))) {
+            return false;
+        }
+        for (uint32_t child : { current.left, current.right }) {
+            if (child != NIL && nodes[child].priority > current.priority) {
+                return false;
+            }
+        }
+        uint32_t below = 0;
+        if (!valid(current.left, low, &current.entry, below) || !valid(current.right, &current.entry, high, below)) {
+            return false;
+        }
+        count += below + 1;
+        return current.size == below + 1;
+    }
+
+    void Board::assign(const std::vector<LeaderboardEntry>& sorted)
+    {
+        //Cartesian tree over the rank order: the stack holds the right spine
+        nodes.clear();
+        nodes.reserve(sorted.size());
+        std::vector<uint32_t> spine;
+        for (const LeaderboardEntry& entry : sorted) {
+            uint32_t node = (uint32_t)nodes.size();
+            nodes.push_back(Node{ entry, priorityOf(entry), 1, NIL, NIL });
+            uint32_t last = NIL;
+            while (!spine.empty() && nodes[spine.back()].priority < nodes[node].priority) {
+                last = spine.back();
+                spine.pop_back();
+            }
+            nodes[node].left = last;
+            if (!spine.empty()) {
+                nodes[spine.back()].right = node;
+            }
+            spine.push_back(node);
+        }
+        root = spine.empty() ? NIL : spine.front();
+        countSizes(root);
+    }
+
+    void Leaderboard::clear()
+    {
+        board_map.clear();
+        account_names.clear();
+        account_index.clear();
+    }
+
+    uint32_t Leaderboard::accountIndex(const std::string& account)
+    {
+        auto result = account_index.try_emplace(account, (uint32_t)account_names.size());
+        if (result.second) {
+            account_names.push_back(account);
+        }
+        return result.first->second;
+    }
+
+    void Leaderboard::add(const Log& log, uint64_t log_id)
+    {
+        if (!log.valid) {
+            return;
+        }
+        const uint32_t week = leaderboardWeek(log.server_start);
+        for (const Player& player : log.players) {
+            if (player.boss_dps == 0) {
+                continue;
+            }
+            add(BoardKey{ log.area_id, player.profession, player.elite_spec, week }, player.account, player.boss_dps, log_id);
+        }
+    }
+
+    void Leaderboard::add(const BoardKey& key, const std::string& account, uint32_t boss_dps, uint64_t log_id)
+    {
+        board_map[key].insert(LeaderboardEntry{ boss_dps, accountIndex(account), log_id });
+    }
+
+    const Board* Leaderboard::find(const BoardKey& key) const
+    {
+        auto it = board_map.find(key);
+        return it != board_map.end() ? &it->second : nullptr;
+    }
+
+    void Leaderboard::serialize(std::vector<uint8_t>& out) const
+    {
+        out.push_back(LEADERBOARD_FORMAT_VERSION);
+        putVarint(out, account_names.size());
+        for (const std::string& account : account_names) {
+            putVarint(out, account.size());
+            out.insert(out.end(), account.begin(), account.end());
+        }
+        putVarint(out, board_map.size());
+        std::vector<LeaderboardEntry> entries;
+        for (const auto& board_pair : board_map) {
+            const BoardKey& key = board_pair.first;
+            putVarint(out, (uint16_t)key.boss);
+            putVarint(out, key.profession);
+            putVarint(out, key.elite_spec);
+            putVarint(out, key.week);
+            board_pair.second.top(board_pair.second.size(), entries);
+            putVarint(out, entries.size());
+            uint32_t previous = entries.empty() ? 0 : entries.front().boss_dps;
+            putVarint(out, previous);
+            for (const LeaderboardEntry& entry : entries) {
+                putVarint(out, previous - entry.boss_dps);
+                putVarint(out, entry.account);
+                putVarint(out, entry.log_id);
+                previous = entry.boss_dps;
+            }
+        }
+    }
+
+    bool Leaderboard::deserialize(const uint8_t* data, size_t len)
+    {
+        clear();
+        const uint8_t* p = data;
+        const uint8_t* end = data + len;
+        if (p == end || *p++ != LEADERBOARD_FORMAT_VERSION) {
+            return false;
+        }
+        uint64_t account_count;
+        if (!getVarint(p, end, account_count) || account_count > (uint64_t)(end - p)) {
+            return false;
+        }
+        account_names.reserve(account_count);
+        for (uint64_t i = 0; i < account_count; ++i) {
+            uint64_t name_len;
+            if (!getVarint(p, end, name_len) || name_len > (uint64_t)(end - p)) {
+                clear();
+                return false;
+            }
+            std::string account((const char*)p, name_len);
+            p += name_len;
+            if (!account_index.emplace(account, (uint32_t)account_names.size()).second) {
+                clear();
+                return false;
+            }
+            account_names.push_back(std::move(account));
+        }
+
+        uint64_t board_count;
+        if (!getVarint(p, end, board_count)) {
+            clear();
+            return false;
+        }
+        std::vector<LeaderboardEntry> entries;
+        for (uint64_t i = 0; i < board_count; ++i) {
+            uint64_t boss, profession, elite_spec, week, entry_count, dps;
+            if (!getVarint(p, end, boss) || !getVarint(p, end, profession) || !getVarint(p, end, elite_spec)
+                || !getVarint(p, end, week) || !getVarint(p, end, entry_count) || !getVarint(p, end, dps)
+                || boss > UINT16_MAX || profession > UINT32_MAX || elite_spec > UINT32_MAX || week > UINT32_MAX
+                || dps > UINT32_MAX || entry_count > (uint64_t)(end - p) / 3) {
+                clear();
+                return false;
+            }
+            entries.clear();
+            for (uint64_t j = 0; j < entry_count; ++j) {
+                uint64_t delta, account, log_id;
+                if (!getVarint(p, end, delta) || !getVarint(p, end, account) || !getVarint(p, end, log_id)
+                    || delta > dps || account >= account_names.size()) {
+                    clear();
+                    return false;
+                }
+                dps -= delta;
+                LeaderboardEntry entry{ (uint32_t)dps, (uint32_t)account, log_id };
+                if (!entries.empty() && Board::before(entry, entries.back())) {
+                    clear();
+                    return false;
+                }
+                entries.push_back(entry);
+            }
+            BoardKey key{ (BossID)boss, (uint32_t)profession, (uint32_t)elite_spec, (uint32_t)week };
+            auto result = board_map.try_emplace(key);
+            if (!result.second) {
+                clear();
+                return false;
+            }
+            result.first->second.assign(entries);
+        }
+        if (p != end) {
+            clear();
+            return false;
+        }
+        return true;
+    }
+
+}
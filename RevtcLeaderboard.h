@@ -0,0 +1,118 @@
+#pragma once
+
+#include "Revtc.h"
+
+namespace Revtc {
+
+	const uint8_t LEADERBOARD_FORMAT_VERSION = 1;
+	const uint32_t LEADERBOARD_WEEK_SECONDS = 7 * 24 * 3600;
+	const uint32_t LEADERBOARD_WEEK_OFFSET = 372600; // first weekly reset after the unix epoch, Monday 07:30 UTC
+
+	//Week of a server unix timestamp, weeks start at the weekly reset
+	inline uint32_t leaderboardWeek(uint32_t server_time)
+	{
+		return server_time < LEADERBOARD_WEEK_OFFSET ? 0 : (server_time - LEADERBOARD_WEEK_OFFSET) / LEADERBOARD_WEEK_SECONDS;
+	}
+
+	//Core builds have elite_spec 0, so the profession keeps them apart
+	struct BoardKey {
+		BossID boss;
+		uint32_t profession;
+		uint32_t elite_spec;
+		uint32_t week;
+
+		bool operator<(const BoardKey& rhs) const
+		{
+			if (boss != rhs.boss) return boss < rhs.boss;
+			if (profession != rhs.profession) return profession < rhs.profession;
+			if (elite_spec != rhs.elite_spec) return elite_spec < rhs.elite_spec;
+			return week < rhs.week;
+		}
+	};
+
+	struct LeaderboardEntry {
+		uint32_t boss_dps;
+		uint32_t account; // index into Leaderboard::account()
+		uint64_t log_id;  // caller's id of the stored parse
+	};
+
+	//One ranking, best first: higher boss dps, then lower log id, then lower account index.
+	//A treap in a flat array whose nodes carry their subtree size, so insert, rank and selection are O(log n)
+	//expected. Priorities are a hash of the entry, which makes the shape depend only on the set of entries and
+	//lets a snapshot in rank order be rebuilt in linear time.
+	class Board
+	{
+	public:
+		Board() : root(NIL) {}
+
+		size_t size() const { return nodes.size(); }
+		void insert(const LeaderboardEntry& entry);
+
+		//Rank a run with boss_dps would get, 1 + the entries with more boss dps
+		size_t rank(uint32_t boss_dps) const;
+		//Rank of the entry, 0 if it is not on the board
+		size_t rankOf(const LeaderboardEntry& entry) const;
+		//Entry at rank, 1 <= rank <= size()
+		const LeaderboardEntry& at(size_t rank) const;
+		//The best k entries (fewer if the board is smaller), in rank order. O(log n + k).
+		void top(size_t k, std::vector<LeaderboardEntry>& out) const;
+		//Checks the treap: rank order, heap order of the priorities and the subtree sizes. O(n), for tests.
+		bool valid() const;
+
+	private:
+		friend class Leaderboard;
+
+		static const uint32_t NIL = UINT32_MAX;
+
+		struct Node {
+			LeaderboardEntry entry;
+			uint32_t priority;
+			uint32_t size;
+			uint32_t left;
+			uint32_t right;
+		};
+
+		std::vector<Node> nodes;
+		uint32_t root;
+
+		static bool before(const LeaderboardEntry& lhs, const LeaderboardEntry& rhs);
+		static uint32_t priorityOf(const LeaderboardEntry& entry);
+		uint32_t sizeOf(uint32_t node) const { return node == NIL ? 0 : nodes[node].size; }
+		uint32_t insert(uint32_t tree, uint32_t node);
+		void split(uint32_t tree, const LeaderboardEntry& entry, uint32_t& left, uint32_t& right);
+		uint32_t countSizes(uint32_t node);
+		bool valid(uint32_t node, const LeaderboardEntry* low, const LeaderboardEntry* high, uint32_t& count) const;
+		//Replaces the board with entries already in rank order
+		void assign(const std::vector<LeaderboardEntry>& sorted);
+	};
+
+	//Boss dps rankings per (boss, profession, elite spec, week) over any number of logs
+	class Leaderboard
+	{
+	public:
+		void clear();
+		//Ranks every player of a valid log with boss damage. The week comes from Log::server_start.
+		//Each log should be added once, log_id is how callers find the stored parse again.
+		void add(const Log& log, uint64_t log_id);
+		void add(const BoardKey& key, const std::string& account, uint32_t boss_dps, uint64_t log_id);
+
+		const Board* find(const BoardKey& key) const;
+		const std::map<BoardKey, Board>& boards() const { return board_map; }
+		const std::string& account(uint32_t index) const { return account_names[index]; }
+		size_t accountCount() const { return account_names.size(); }
+
+		//Compact form: u8 version, the account names, then per board its key and the entries in rank order
+		//as varints with boss dps delta coded. Restoring does not re-sort.
+		void serialize(std::vector<uint8_t>& out) const;
+		//Replaces the contents, false (and empty) on a malformed or unsupported buffer
+		bool deserialize(const uint8_t* data, size_t len);
+
+	private:
+		std::map<BoardKey, Board> board_map;
+		std::vector<std::string> account_names;
+		std::unordered_map<std::string, uint32_t> account_index;
+
+		uint32_t accountIndex(const std::string& account);
+	};
+
+}
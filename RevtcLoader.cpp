@@ -0,0 +1,390 @@
+#include "RevtcLoader.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+#if defined(REVTC_IO_URING) && defined(__linux__)
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+
+namespace Revtc {
+
+#if defined(REVTC_IO_URING) && defined(__linux__)
+    //Minimal io_uring wrapper over the raw syscalls: one submission and one completion queue,
+    //driven from the I/O thread only.
+    struct Loader::Ring {
+        int fd = -1;
+        void* sq_ptr = MAP_FAILED;
+        size_t sq_len = 0;
+        void* cq_ptr = MAP_FAILED;
+        size_t cq_len = 0;
+        io_uring_sqe* sqes = (io_uring_sqe*)MAP_FAILED;
+        size_t sqes_len = 0;
+        unsigned* sq_head;
+        unsigned* sq_tail;
+        unsigned* sq_mask;
+        unsigned* sq_array;
+        unsigned* cq_head;
+        unsigned* cq_tail;
+        unsigned* cq_mask;
+        io_uring_cqe* cqes;
+        unsigned pending = 0;
+        //Buffers of a file whose reads could not be waited out, kept until their completions are reaped
+        std::vector<std::vector<uint8_t>> parked;
+        unsigned parked_reads = 0;
+
+        bool open(unsigned entries)
+        {
+            io_uring_params params;
+            memset(&params, 0, sizeof(params));
+            fd = (int)syscall(__NR_io_uring_setup, entries, &params);
+            if (fd < 0) return false;
+
+            sq_len = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+            cq_len = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+            if (params.features & IORING_FEAT_SINGLE_MMAP) sq_len = cq_len = std::max(sq_len, cq_len);
+
+            sq_ptr = mmap(nullptr, sq_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+            if (sq_ptr == MAP_FAILED) return false;
+            if (params.features & IORING_FEAT_SINGLE_MMAP) {
+                cq_ptr = sq_ptr;
+            } else {
+                cq_ptr = mmap(nullptr, cq_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+                if (cq_ptr == MAP_FAILED) return false;
+            }
+            sqes_len = params.sq_entries * sizeof(io_uring_sqe);
+            sqes = (io_uring_sqe*)mmap(nullptr, sqes_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+            if (sqes == MAP_FAILED) return false;
+
+            char* sq = (char*)sq_ptr;
+            char* cq = (char*)cq_ptr;
+            sq_head = (unsigned*)(sq + params.sq_off.head);
+            sq_tail = (unsigned*)(sq + params.sq_off.tail);
+            sq_mask = (unsigned*)(sq + params.sq_off.ring_mask);
+            sq_array = (unsigned*)(sq + params.sq_off.array);
+            cq_head = (unsigned*)(cq + params.cq_off.head);
+            cq_tail = (unsigned*)(cq + params.cq_off.tail);
+            cq_mask = (unsigned*)(cq + params.cq_off.ring_mask);
+            cqes = (io_uring_cqe*)(cq + params.cq_off.cqes);
+            return true;
+        }
+
+        ~Ring()
+        {
+            //One more try at reaping the parked reads. If the kernel still refuses, closing the ring below
+            //cancels them before the buffers are freed.
+            while (parked_reads > 0 && fd >= 0 && wait()) {
+                reap([this](uint64_t, int) {
+                    if (parked_reads > 0) --parked_reads;
+                });
+            }
+            if (sqes != MAP_FAILED) munmap(sqes, sqes_len);
+            if (cq_ptr != MAP_FAILED && cq_ptr != sq_ptr) munmap(cq_ptr, cq_len);
+            if (sq_ptr != MAP_FAILED) munmap(sq_ptr, sq_len);
+            if (fd >= 0) close(fd);
+        }
+
+        void read(int file, void* dst, unsigned len, uint64_t offset, uint64_t tag)
+        {
+            unsigned tail = *sq_tail;
+            unsigned index = tail & *sq_mask;
+            io_uring_sqe& sqe = sqes[index];
+            memset(&sqe, 0, sizeof(sqe));
+            sqe.opcode = IORING_OP_READ;
+            sqe.fd = file;
+            sqe.addr = (uint64_t)(uintptr_t)dst;
+            sqe.len = len;
+            sqe.off = offset;
+            sqe.user_data = tag;
+            sq_array[index] = index;
+            __atomic_store_n(sq_tail, tail + 1, __ATOMIC_RELEASE);
+            ++pending;
+        }
+
+        //Submits queued reads and waits for at least one completion
+        bool wait()
+        {
+            for (;;) {
+                int ret = (int)syscall(__NR_io_uring_enter, fd, pending, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+                if (ret >= 0) {
+                    pending -= std::min(pending, (unsigned)ret);
+                    return true;
+                }
+                if (errno != EINTR) return false;
+            }
+        }
+
+        //Takes back the queued reads the kernel has not consumed yet, passing each tag to fn.
+        //Without SQPOLL the kernel only reads the queue inside io_uring_enter, so this cannot race it.
+        template<typename Fn>
+        void retract(Fn fn)
+        {
+            unsigned head = __atomic_load_n(sq_head, __ATOMIC_ACQUIRE);
+            unsigned tail = *sq_tail;
+            for (unsigned i = head; i != tail; ++i) {
+                fn(sqes[sq_array[i & *sq_mask]].user_data);
+            }
+            __atomic_store_n(sq_tail, head, __ATOMIC_RELEASE);
+            pending = 0;
+        }
+
+        template<typename Fn>
+        void reap(Fn fn)
+        {
+            unsigned head = *cq_head;
+            unsigned tail = __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE);
+            for (; head != tail; ++head) {
+                const io_uring_cqe& cqe = cqes[head & *cq_mask];
+                fn(cqe.user_data, cqe.res);
+            }
+            __atomic_store_n(cq_head, head, __ATOMIC_RELEASE);
+        }
+    };
+#else
+    struct Loader::Ring {};
+#endif
+
+    Loader::Loader(std::vector<std::string> paths, const LoaderOptions& options)
+        : paths(std::move(paths))
+        , options(options)
+        , handed_out(0)
+        , stopping(false)
+        , ring(nullptr)
+        , ring_usable(false)
+    {
+        if (this->options.queue_depth == 0) this->options.queue_depth = 1;
+        if (this->options.read_size == 0) this->options.read_size = 4 << 20;
+        if (this->options.reads_in_flight == 0) this->options.reads_in_flight = 1;
+
+        //One more buffer than the queue depth so the consumer can hold one while the queue stays full
+        size_t buffers = std::min(this->options.queue_depth + 1, std::max<size_t>(this->paths.size(), 1));
+        for (size_t i = 0; i < buffers; ++i) {
+            pool.emplace_back(new LoadedLog());
+            free_logs.push_back(pool.back().get());
+        }
+
+#if defined(REVTC_IO_URING) && defined(__linux__)
+        ring = new Ring();
+        if (!ring->open(this->options.reads_in_flight)) {
+            delete ring;
+            ring = nullptr;
+        }
+        ring_usable.store(ring != nullptr, std::memory_order_release);
+#endif
+
+        io = std::thread(&Loader::run, this);
+    }
+
+    Loader::~Loader()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        has_free.notify_all();
+        io.join();
+        delete ring;
+    }
+
+    LoadedLog* Loader::next()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        if (handed_out == paths.size()) return nullptr;
+        has_ready.wait(lock, [this] { return !ready.empty(); });
+        LoadedLog* log = ready.front();
+        ready.pop_front();
+        ++handed_out;
+        return log;
+    }
+
+    void Loader::release(LoadedLog* log)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            free_logs.push_back(log);
+        }
+        has_free.notify_one();
+    }
+
+    void Loader::run()
+    {
+        for (size_t i = 0; i < paths.size(); ++i) {
+            LoadedLog* log;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                has_free.wait(lock, [this] { return stopping || !free_logs.empty(); });
+                if (stopping) return;
+                log = free_logs.back();
+                free_logs.pop_back();
+            }
+
+            log->index = i;
+            log->path = paths[i];
+            readFile(*log);
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                ready.push_back(log);
+            }
+            has_ready.notify_one();
+        }
+    }
+
+    void Loader::readFile(LoadedLog& log)
+    {
+        log.data.clear();
+        log.error.clear();
+
+#ifdef _WIN32
+        int fd = _open(log.path.c_str(), _O_RDONLY | _O_BINARY);
+        struct _stat64 st;
+        bool sized = fd >= 0 && _fstat64(fd, &st) == 0;
+#else
+        int fd = open(log.path.c_str(), O_RDONLY);
+        struct stat st;
+        bool sized = fd >= 0 && fstat(fd, &st) == 0 && S_ISREG(st.st_mode);
+#endif
+        if (fd < 0) {
+            log.error = std::string("Cannot open file: ") + strerror(errno);
+            return;
+        }
+
+        //Regular files are read at known offsets, anything else streams to end of file
+        size_t size = sized ? (size_t)st.st_size : 0;
+        if (size > 0 && ring_usable.load(std::memory_order_relaxed)) {
+            readRing(fd, log, size);
+        } else {
+            readPlain(fd, log, size);
+        }
+
+#ifdef _WIN32
+        _close(fd);
+#else
+        close(fd);
+#endif
+    }
+
+    bool Loader::readPlain(int fd, LoadedLog& log, size_t size)
+    {
+        size_t len = 0;
+        log.data.resize(size > 0 ? size : options.read_size);
+        for (;;) {
+            if (len == log.data.size()) {
+                if (size > 0) break;
+                log.data.resize(log.data.size() * 2);
+            }
+            size_t want = std::min(options.read_size, log.data.size() - len);
+#ifdef _WIN32
+            int got = _read(fd, log.data.data() + len, (unsigned int)std::min<size_t>(want, 1u << 30));
+#else
+            ssize_t got = ::read(fd, log.data.data() + len, want);
+#endif
+            if (got < 0) {
+                if (errno == EINTR) continue;
+                log.error = std::string("Read failed: ") + strerror(errno);
+                log.data.clear();
+                return false;
+            }
+            if (got == 0) break;
+            len += (size_t)got;
+        }
+        log.data.resize(len);
+        return true;
+    }
+
+    bool Loader::readRing(int fd, LoadedLog& log, size_t size)
+    {
+#if defined(REVTC_IO_URING) && defined(__linux__)
+        struct Request {
+            uint64_t offset;
+            uint32_t len;
+        };
+        std::vector<Request> requests(options.reads_in_flight);
+        std::vector<uint32_t> idle;
+        for (uint32_t i = 0; i < requests.size(); ++i) idle.push_back(i);
+
+        log.data.resize(size);
+        uint8_t* base = log.data.data();
+        uint32_t chunk = (uint32_t)std::min<size_t>(options.read_size, 1u << 30);
+        uint64_t next_offset = 0;
+        size_t remaining = size;
+        bool failed = false;
+        int error = 0;
+
+        while (remaining > 0 || idle.size() < requests.size()) {
+            while (!failed && !idle.empty() && next_offset < size) {
+                uint32_t r = idle.back();
+                idle.pop_back();
+                requests[r].offset = next_offset;
+                requests[r].len = (uint32_t)std::min<uint64_t>(chunk, size - next_offset);
+                ring->read(fd, base + requests[r].offset, requests[r].len, requests[r].offset, r);
+                next_offset += requests[r].len;
+            }
+            if (idle.size() == requests.size()) break;
+
+            if (!ring->wait()) {
+                //The ring is not used again, later files and this one go through read(). log.data must not be
+                //touched while the kernel may still write to it: take back the reads it has not seen and wait
+                //out the rest.
+                ring_usable.store(false, std::memory_order_release);
+                error = errno;
+                ring->retract([&](uint64_t tag) { idle.push_back((uint32_t)tag); });
+                while (idle.size() < requests.size()) {
+                    ring->reap([&](uint64_t tag, int) { idle.push_back((uint32_t)tag); });
+                    if (idle.size() < requests.size() && !ring->wait() && errno != EAGAIN && errno != EBUSY) {
+                        //Reads still in flight that cannot be waited for. Their buffer moves into the ring,
+                        //which lives until the loader is destroyed.
+                        ring->parked.push_back(std::move(log.data));
+                        ring->parked_reads += (unsigned)(requests.size() - idle.size());
+                        log.error = std::string("Read failed: ") + strerror(error);
+                        log.data.clear();
+                        return false;
+                    }
+                }
+                lseek(fd, 0, SEEK_SET);
+                return readPlain(fd, log, size);
+            }
+            ring->reap([&](uint64_t tag, int res) {
+                Request& request = requests[tag];
+                if (res > 0 && (uint32_t)res < request.len) {
+                    //Short read, ask for the rest
+                    request.offset += res;
+                    request.len -= res;
+                    remaining -= res;
+                    ring->read(fd, base + request.offset, request.len, request.offset, tag);
+                    return;
+                }
+                if (res <= 0) {
+                    //Error, or the file shrank since fstat
+                    failed = true;
+                    if (res < 0) error = -res;
+                } else {
+                    remaining -= res;
+                }
+                idle.push_back((uint32_t)tag);
+            });
+        }
+
+        if (!failed) return true;
+        if (error == 0 && idle.size() == requests.size()) {
+            //Truncated while reading: take whatever the file holds now
+            lseek(fd, 0, SEEK_SET);
+            return readPlain(fd, log, 0);
+        }
+        log.error = std::string("Read failed: ") + strerror(error ? error : EIO);
+        log.data.clear();
+        return false;
+#else
+        return readPlain(fd, log, size);
+#endif
+    }
+
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "Revtc.h"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace Revtc {
+
+	//Read-ahead file loader: a dedicated I/O thread reads logs in path order into pooled buffers
+	//while the caller parses the previous ones.
+	//
+	//  Loader loader(paths);
+	//  Parser parser(nullptr, 0);
+	//  Log log;
+	//  while (LoadedLog* file = loader.next()) {
+	//      if (file->error.empty()) parser.parse(file->data.data(), file->data.size(), log);
+	//      loader.release(file);
+	//  }
+	//
+	//Build with REVTC_IO_URING on Linux to issue the reads through io_uring, otherwise (or when the
+	//kernel refuses the ring) files are read with plain read() calls.
+	struct LoaderOptions {
+		size_t queue_depth = 4;          // logs read ahead of the consumer
+		size_t read_size = 4 << 20;      // bytes per read request
+		unsigned reads_in_flight = 4;    // io_uring only, concurrent requests per file
+	};
+
+	struct LoadedLog {
+		size_t index;        // position in the path list
+		std::string path;
+		std::vector<uint8_t> data;
+		std::string error;   // empty when the whole file was read
+	};
+
+	class Loader
+	{
+	public:
+		explicit Loader(std::vector<std::string> paths, const LoaderOptions& options = LoaderOptions());
+		~Loader();
+
+		Loader(const Loader&) = delete;
+		Loader& operator=(const Loader&) = delete;
+
+		//Blocks until the next log is loaded, nullptr once every path has been handed out
+		LoadedLog* next();
+		//Hands a log's buffer back to the pool, the log must not be used afterwards
+		void release(LoadedLog* log);
+
+		//True when reads go through io_uring, false from the start or after the ring failed
+		bool usingIoUring() const { return ring_usable.load(std::memory_order_acquire); }
+
+	private:
+		struct Ring;
+
+		std::vector<std::string> paths;
+		LoaderOptions options;
+		std::vector<std::unique_ptr<LoadedLog>> pool;
+		std::vector<LoadedLog*> free_logs;
+		std::deque<LoadedLog*> ready;
+		size_t handed_out;
+		bool stopping;
+		std::mutex mutex;
+		std::condition_variable has_free;
+		std::condition_variable has_ready;
+		Ring* ring; // owned by the I/O thread until it is joined
+		std::atomic<bool> ring_usable;
+		std::thread io;
+
+		void run();
+		void readFile(LoadedLog& log);
+		bool readPlain(int fd, LoadedLog& log, size_t size);
+		bool readRing(int fd, LoadedLog& log, size_t size);
+	};
+
+}
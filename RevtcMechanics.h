@@ -0,0 +1,66 @@
+#pragma once
+
+#include "Revtc.h"
+
+namespace Revtc {
+
+	//Encounter specific checks. Every hook is static and the defaults are empty, so each encounter compiles its
+	//own event loop with only the checks it overrides, and other encounters pay nothing for them.
+	//To add an encounter, derive from Mechanics, override what it needs and add a case to dispatchMechanics.
+	struct Mechanics {
+		//Once per log after the header, e.g. extra boss ids
+		static void encounter(Log& /*log*/) {}
+		//Once per agent after the agent table is read
+		static void agent(Log& /*log*/, const Agent& /*agent*/) {}
+		//Physical hit with a known source. Returns the agent whose note counter the hit counts for, or nullptr.
+		static const Agent* physical(const CombatEvent& /*event*/, const Agent& /*src*/, const Agent* /*dst*/) { return nullptr; }
+		//Note given to the player with the highest note counter, nullptr for none
+		static const char* note() { return nullptr; }
+	};
+
+	struct KeepConstructMechanics : Mechanics {
+		//Players hitting the construct core are pushing orbs
+		static const Agent* physical(const CombatEvent& /*event*/, const Agent& src, const Agent* dst)
+		{
+			return dst && dst->species_id == KC_CONSTRUCT_CORE ? &src : nullptr;
+		}
+		static const char* note() { return "Orb Pusher"; }
+	};
+
+	struct DeimosMechanics : Mechanics {
+		//Deimos turns into a gadget at 10%
+		static void agent(Log& log, const Agent& agent)
+		{
+			if (agent.agtype == AgentType::Gadget && agent.name == "Deimos") {
+				log.boss_ids.emplace(agent.species_id);
+			}
+		}
+		//The player the hands keep hitting is the one kiting them
+		static const Agent* physical(const CombatEvent& /*event*/, const Agent& src, const Agent* dst)
+		{
+			return src.species_id == DEIMOS_HANDS && dst && dst->agtype == AgentType::Player ? dst : nullptr;
+		}
+		static const char* note() { return "Hand Kiter"; }
+	};
+
+	struct TwinLargosMechanics : Mechanics {
+		//Nikare and Kenut share the encounter
+		static void encounter(Log& log)
+		{
+			log.boss_ids.emplace(static_cast<uint16_t>(BossID::KENUT));
+		}
+	};
+
+	//Calls fn with a value of the mechanics type for the encounter
+	template<typename Fn>
+	inline void dispatchMechanics(BossID area_id, Fn&& fn)
+	{
+		switch (area_id) {
+			case BossID::KEEP_CONSTRUCT: fn(KeepConstructMechanics()); break;
+			case BossID::DEIMOS: fn(DeimosMechanics()); break;
+			case BossID::NIKARE: fn(TwinLargosMechanics()); break;
+			default: fn(Mechanics()); break;
+		}
+	}
+
+}
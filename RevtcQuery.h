@@ -0,0 +1,101 @@
+#pragma once
+
+#include "Revtc.h"
+
+namespace Revtc {
+
+	enum class EventColumn : uint8_t {
+		TIME,
+		SRC, // agent index
+		DST, // agent index
+		VALUE,
+		BUFF_DMG,
+		SKILLID,
+		IFF,
+		BUFF,
+		RESULT,
+		IS_ACTIVATION,
+		IS_BUFFREMOVE,
+		IS_NINETY,
+		IS_FIFTY,
+		IS_MOVING,
+		IS_STATECHANGE,
+		IS_FLANKING,
+		IS_SHIELDS,
+		IS_OFFCYCLE,
+	};
+
+	//Decoded events as one array per field. Agents are stored by Agent::index, addresses outside the
+	//agent table map to agent_count.
+	struct EventColumns {
+		uint32_t agent_count = 0;
+		std::vector<uint64_t> time;
+		std::vector<uint32_t> src;
+		std::vector<uint32_t> dst;
+		std::vector<int32_t> value;
+		std::vector<int32_t> buff_dmg;
+		std::vector<uint32_t> skillid;
+		std::vector<uint8_t> iff;
+		std::vector<uint8_t> buff;
+		std::vector<uint8_t> result;
+		std::vector<uint8_t> is_activation;
+		std::vector<uint8_t> is_buffremove;
+		std::vector<uint8_t> is_ninety;
+		std::vector<uint8_t> is_fifty;
+		std::vector<uint8_t> is_moving;
+		std::vector<uint8_t> is_statechange;
+		std::vector<uint8_t> is_flanking;
+		std::vector<uint8_t> is_shields;
+		std::vector<uint8_t> is_offcycle;
+
+		void build(const Parser& parser);
+		void clear();
+		void reserve(size_t rows);
+		void append(const CombatEvent& event, uint32_t src_index, uint32_t dst_index);
+		size_t size() const { return time.size(); }
+	};
+
+	//Conjunction of column predicates evaluated block by block into byte masks (0xFF/0x00 per row), which
+	//the compiler turns into packed compares and ANDs. Aggregates only read rows whose mask is set.
+	class EventQuery
+	{
+	public:
+		EventQuery& equals(EventColumn column, int64_t v);
+		EventQuery& notEquals(EventColumn column, int64_t v);
+		EventQuery& between(EventColumn column, int64_t from, int64_t to); // from <= x < to
+		EventQuery& in(EventColumn column, const std::vector<uint32_t>& values); // SRC, DST or SKILLID
+
+		//Direct damage hits: no buff, statechange, activation or buff removal
+		EventQuery& physical();
+
+		uint64_t count(const EventColumns& columns) const;
+		int64_t sum(const EventColumns& columns, EventColumn column) const;
+		//Indexed by agent index, with one extra entry for agents outside the agent table. group must be SRC or
+		//DST, any other column returns an empty vector.
+		std::vector<uint64_t> countBy(const EventColumns& columns, EventColumn group) const;
+		std::vector<int64_t> sumBy(const EventColumns& columns, EventColumn column, EventColumn group) const;
+
+	private:
+		enum class Op : uint8_t {
+			EQ,
+			NE,
+			RANGE,
+			IN,
+		};
+
+		struct Predicate {
+			EventColumn column;
+			Op op;
+			int64_t a;
+			int64_t b;
+			std::vector<uint32_t> values;
+		};
+
+		std::vector<Predicate> predicates;
+
+		template<typename Fn> void scan(const EventColumns& columns, Fn&& consume) const;
+		void apply(const Predicate& predicate, const EventColumns& columns, size_t begin, size_t n, uint8_t* mask,
+			std::vector<uint8_t>& lookup, uint8_t* scratch) const;
+	};
+
+}
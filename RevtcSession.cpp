@@ -0,0 +1,211 @@
+#include "RevtcSession.h"
+#include <algorithm>
+#include <cmath>
+
+namespace Revtc {
+
+    static void putVarint(std::vector<uint8_t>& out, uint64_t v)
+    {
+        while (v >= 0x80) {
+            out.push_back((uint8_t)(v | 0x80));
+            v >>= 7;
+        }
+        out.push_back((uint8_t)v);
+    }
+
+    static bool getVarint(const uint8_t*& p, const uint8_t* end, uint64_t& v)
+    {
+        v = 0;
+        for (unsigned shift = 0; shift < 64; shift += 7) {
+            if (p == end) return false;
+            uint8_t byte = *p++;
+            v |= (uint64_t)(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) return true;
+        }
+        return false;
+    }
+
+    void AccountTotals::add(const Player& player, uint64_t duration_ms)
+    {
+        ++logs;
+        this->duration_ms += duration_ms;
+        physical_damage += player.physical_damage;
+        condi_damage += player.condi_damage;
+        boss_physical_damage += player.boss_physical_damage;
+        boss_condi_damage += player.boss_condi_damage;
+        if (buff_stack_ms.size() < player.buffs.size()) buff_stack_ms.resize(player.buffs.size(), 0);
+        for (size_t i = 0; i < player.buffs.size(); ++i) {
+            buff_stack_ms[i] += (uint64_t)llround((double)player.buffs[i] * (double)duration_ms);
+        }
+    }
+
+    void AccountTotals::merge(const AccountTotals& other)
+    {
+        logs += other.logs;
+        duration_ms += other.duration_ms;
+        physical_damage += other.physical_damage;
+        condi_damage += other.condi_damage;
+        boss_physical_damage += other.boss_physical_damage;
+        boss_condi_damage += other.boss_condi_damage;
+        if (buff_stack_ms.size() < other.buff_stack_ms.size()) buff_stack_ms.resize(other.buff_stack_ms.size(), 0);
+        for (size_t i = 0; i < other.buff_stack_ms.size(); ++i) {
+            buff_stack_ms[i] += other.buff_stack_ms[i];
+        }
+    }
+
+    float AccountTotals::dps() const
+    {
+        return duration_ms ? (float)((double)(physical_damage + condi_damage) * 1000.0 / duration_ms) : 0.0f;
+    }
+
+    float AccountTotals::bossDps() const
+    {
+        return duration_ms ? (float)((double)(boss_physical_damage + boss_condi_damage) * 1000.0 / duration_ms) : 0.0f;
+    }
+
+    float AccountTotals::buffAverage(uint16_t buff) const
+    {
+        if (!duration_ms || buff >= buff_stack_ms.size()) return 0.0f;
+        return (float)((double)buff_stack_ms[buff] / duration_ms);
+    }
+
+    void Session::clear()
+    {
+        totals.clear();
+        log_count = 0;
+        duration_ms = 0;
+    }
+
+    AccountTotals& Session::entry(const std::string& account)
+    {
+        auto it = std::lower_bound(totals.begin(), totals.end(), account,
+            [](const AccountTotals& totals, const std::string& account) { return totals.account < account; });
+        if (it == totals.end() || it->account != account) {
+            AccountTotals fresh{};
+            fresh.account = account;
+            it = totals.insert(it, std::move(fresh));
+        }
+        return *it;
+    }
+
+    void Session::add(const Log& log)
+    {
+        if (!log.valid || log.encounter_duration_ms == 0) return;
+        ++log_count;
+        duration_ms += log.encounter_duration_ms;
+        for (const Player& player : log.players) {
+            entry(player.account).add(player, log.encounter_duration_ms);
+        }
+    }
+
+    void Session::merge(const Session& other)
+    {
+        log_count += other.log_count;
+        duration_ms += other.duration_ms;
+
+        //Both sides are sorted by account, so this is a single merge pass
+        std::vector<AccountTotals> merged;
+        merged.reserve(totals.size() + other.totals.size());
+        auto a = totals.begin();
+        auto b = other.totals.begin();
+        while (a != totals.end() || b != other.totals.end()) {
+            if (b == other.totals.end() || (a != totals.end() && a->account < b->account)) {
+                merged.push_back(std::move(*a++));
+            } else if (a == totals.end() || b->account < a->account) {
+                merged.push_back(*b++);
+            } else {
+                a->merge(*b++);
+                merged.push_back(std::move(*a++));
+            }
+        }
+        totals.swap(merged);
+    }
+
+    const AccountTotals* Session::find(const std::string& account) const
+    {
+        auto it = std::lower_bound(totals.begin(), totals.end(), account,
+            [](const AccountTotals& totals, const std::string& account) { return totals.account < account; });
+        return it != totals.end() && it->account == account ? &*it : nullptr;
+    }
+
+    void Session::serialize(std::vector<uint8_t>& out) const
+    {
+        out.clear();
+        out.push_back(SESSION_FORMAT_VERSION);
+        putVarint(out, log_count);
+        putVarint(out, duration_ms);
+
+        uint16_t buff_count = BuffRegistry::count();
+        putVarint(out, buff_count);
+        for (uint16_t i = 0; i < buff_count; ++i) {
+            putVarint(out, BuffRegistry::at(i).id);
+        }
+
+        putVarint(out, totals.size());
+        for (const AccountTotals& account : totals) {
+            putVarint(out, account.account.size());
+            out.insert(out.end(), account.account.begin(), account.account.end());
+            putVarint(out, account.logs);
+            putVarint(out, account.duration_ms);
+            putVarint(out, account.physical_damage);
+            putVarint(out, account.condi_damage);
+            putVarint(out, account.boss_physical_damage);
+            putVarint(out, account.boss_condi_damage);
+            for (uint16_t i = 0; i < buff_count; ++i) {
+                putVarint(out, i < account.buff_stack_ms.size() ? account.buff_stack_ms[i] : 0);
+            }
+        }
+    }
+
+    bool Session::deserialize(const uint8_t* data, size_t len)
+    {
+        clear();
+        const uint8_t* p = data;
+        const uint8_t* end = data + len;
+        uint64_t v;
+
+        if (len == 0 || *p++ != SESSION_FORMAT_VERSION) return false;
+        if (!getVarint(p, end, v)) return false;
+        log_count = (uint32_t)v;
+        if (!getVarint(p, end, duration_ms)) { clear(); return false; }
+
+        //Map the writer's buff order onto ours
+        uint64_t buff_count;
+        if (!getVarint(p, end, buff_count) || buff_count > (uint64_t)(end - p)) { clear(); return false; }
+        std::vector<uint16_t> buff_map(buff_count);
+        for (auto& buff : buff_map) {
+            if (!getVarint(p, end, v)) { clear(); return false; }
+            buff = BuffRegistry::index((uint32_t)v);
+        }
+
+        uint64_t account_count;
+        if (!getVarint(p, end, account_count) || account_count > (uint64_t)(end - p)) { clear(); return false; }
+        totals.resize(account_count);
+        bool ok = true;
+        for (AccountTotals& account : totals) {
+            uint64_t name_len;
+            if (!getVarint(p, end, name_len) || name_len > (uint64_t)(end - p)) { ok = false; break; }
+            account.account.assign((const char*)p, name_len);
+            p += name_len;
+            ok = getVarint(p, end, v);
+            account.logs = (uint32_t)v;
+            ok = ok && getVarint(p, end, account.duration_ms)
+                && getVarint(p, end, account.physical_damage)
+                && getVarint(p, end, account.condi_damage)
+                && getVarint(p, end, account.boss_physical_damage)
+                && getVarint(p, end, account.boss_condi_damage);
+            account.buff_stack_ms.assign(BuffRegistry::count(), 0);
+            for (uint16_t buff : buff_map) {
+                if (!ok || !getVarint(p, end, v)) { ok = false; break; }
+                if (buff != BUFF_NONE) account.buff_stack_ms[buff] = v;
+            }
+            if (!ok) break;
+        }
+
+        ok = ok && p == end && std::adjacent_find(totals.begin(), totals.end(),
+            [](const AccountTotals& a, const AccountTotals& b) { return a.account >= b.account; }) == totals.end();
+        if (!ok) clear();
+        return ok;
+    }
+
+}
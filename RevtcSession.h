@@ -0,0 +1,61 @@
+#pragma once
+
+#include "Revtc.h"
+
+namespace Revtc {
+
+	const uint8_t SESSION_FORMAT_VERSION = 1;
+
+	//Totals of one account over any number of logs. Everything is kept as integer sums (damage,
+	//milliseconds, stack-milliseconds) so add() and merge() are exactly associative and commutative and
+	//a batch can be reduced in any order or tree shape with the same result.
+	struct AccountTotals {
+		std::string account;
+		uint32_t logs;
+		uint64_t duration_ms;
+		uint64_t physical_damage;
+		uint64_t condi_damage;
+		uint64_t boss_physical_damage;
+		uint64_t boss_condi_damage;
+		std::vector<uint64_t> buff_stack_ms; // by buff index, average stacks weighted by duration
+
+		void add(const Player& player, uint64_t duration_ms);
+		void merge(const AccountTotals& other);
+
+		//Damage over the summed encounter time, i.e. DPS weighted by duration
+		float dps() const;
+		float bossDps() const;
+		float buffAverage(uint16_t buff) const;
+	};
+
+	//Per-account accumulators for a set of logs, sorted by account name
+	class Session
+	{
+	public:
+		Session() : log_count(0), duration_ms(0) {}
+
+		void clear();
+		//Skips invalid logs and logs without an encounter duration
+		void add(const Log& log);
+		void merge(const Session& other);
+
+		const AccountTotals* find(const std::string& account) const;
+		const std::vector<AccountTotals>& accounts() const { return totals; }
+		uint32_t logs() const { return log_count; }
+		uint64_t durationMs() const { return duration_ms; }
+
+		//Compact form: u8 version, then varints. Buffs are stored by skill id so partial sessions from
+		//builds with a different buff table still merge, unknown ids are dropped on read.
+		void serialize(std::vector<uint8_t>& out) const;
+		//Replaces the contents, false (and empty) on a malformed or unsupported buffer
+		bool deserialize(const uint8_t* data, size_t len);
+
+	private:
+		std::vector<AccountTotals> totals;
+		uint32_t log_count;
+		uint64_t duration_ms;
+
+		AccountTotals& entry(const std::string& account);
+	};
+
+}
@@ -0,0 +1,230 @@
+#include "RevtcWvw.h"
+#include <algorithm>
+#include <cstring>
+
+namespace Revtc {
+
+    static const uint16_t WVW_NONE = 0xFFFF;
+
+    uint16_t WvwParser::find(uint64_t addr) const
+    {
+        auto it = std::lower_bound(by_addr.begin(), by_addr.end(), std::make_pair(addr, (uint16_t)0));
+        return it != by_addr.end() && it->first == addr ? it->second : WVW_NONE;
+    }
+
+    void WvwParser::parse(const unsigned char* buf, size_t len, WvwLog& log)
+    {
+        log.valid = false;
+        log.error.clear();
+        log.version.clear();
+        log.revision = 0;
+        log.pov_addr = 0;
+        log.pov_subgroup = 0;
+        log.server_start = 0;
+        log.log_start = 0;
+        log.log_end = 0;
+        log.event_count = 0;
+        log.players.clear();
+        log.names.clear();
+        log.generation.clear();
+        log.memory = WvwMemory{};
+        by_addr.clear();
+
+        if (len < 20 || memcmp(buf, "EVTC", 4) != 0) {
+            log.error = "Corrupted or otherwise invalid EVTC file.";
+            return;
+        }
+        log.version.assign((const char*)&buf[4], 8);
+        log.revision = buf[12];
+
+        //Agents: squad members are the players that come with an account name
+        uint32_t agent_count;
+        memcpy(&agent_count, &buf[16], sizeof(agent_count));
+        size_t index = 20;
+        if (agent_count > (len - index) / 96) {
+            log.error = "Agent table runs past the end of the file.";
+            return;
+        }
+        log.memory.agents = agent_count;
+        for (uint32_t i = 0; i < agent_count; ++i, index += 96) {
+            uint32_t is_elite;
+            memcpy(&is_elite, &buf[index + 12], sizeof(is_elite));
+            if (is_elite == 0xFFFFFFFF) {
+                continue;
+            }
+            const char* name = (const char*)&buf[index + 28];
+            size_t name_len = strnlen(name, 64);
+            if (name_len + 2 >= 64) {
+                continue;
+            }
+            const char* account = name + name_len + 2;
+            size_t account_len = strnlen(account, 64 - name_len - 2);
+            if (account_len == 0) {
+                continue;
+            }
+            uint16_t subgroup = 0;
+            for (const char* c = account + account_len + 1; c < name + 64 && *c >= '0' && *c <= '9'; ++c) {
+                subgroup = subgroup * 10 + (*c - '0');
+            }
+
+            WvwPlayer player{};
+            memcpy(&player.addr, &buf[index], sizeof(player.addr));
+            memcpy(&player.profession, &buf[index + 8], sizeof(player.profession));
+            player.elite_spec = is_elite;
+            player.subgroup = subgroup;
+            player.name = (uint32_t)log.names.size();
+            log.names.append(name, name_len).push_back('\0');
+            player.account = (uint32_t)log.names.size();
+            log.names.append(account, account_len).push_back('\0');
+            log.players.push_back(player);
+        }
+
+        //Skills
+        uint32_t skill_count = 0;
+        if (len - index >= sizeof(skill_count)) {
+            memcpy(&skill_count, &buf[index], sizeof(skill_count));
+            index += sizeof(skill_count);
+        }
+        if (skill_count > (len - index) / 68) {
+            log.error = "Skill table runs past the end of the file.";
+            log.players.clear();
+            log.names.clear();
+            return;
+        }
+        index += (size_t)skill_count * 68;
+
+        const size_t stride = log.revision == 0 ? sizeof(CombatEventRev0) : sizeof(CombatEvent);
+        const size_t event_count = (len - index) / stride;
+        const unsigned char* events = &buf[index];
+        log.event_count = event_count;
+        CombatEvent event;
+
+        //The POV statechange comes near the start, find it before filtering the squad
+        for (size_t i = 0; i < event_count; ++i) {
+            Parser::decodeEvent(events + i * stride, log.revision, event);
+            if (event.is_statechange == CBTS_POINTOFVIEW) {
+                log.pov_addr = event.src_agent;
+                break;
+            }
+        }
+        for (const WvwPlayer& player : log.players) {
+            if (player.addr == log.pov_addr) {
+                log.pov_subgroup = player.subgroup;
+            }
+        }
+        if (options.scope == WvwScope::SUBGROUP && log.pov_addr) {
+            log.players.erase(std::remove_if(log.players.begin(), log.players.end(),
+                [&](const WvwPlayer& player) { return player.subgroup != log.pov_subgroup; }), log.players.end());
+        }
+        if (log.players.size() >= WVW_NONE) {
+            log.players.resize(WVW_NONE - 1);
+        }
+
+        for (size_t i = 0; i < log.players.size(); ++i) {
+            by_addr.emplace_back(log.players[i].addr, (uint16_t)i);
+        }
+        std::sort(by_addr.begin(), by_addr.end());
+        by_instid.assign(65536, WVW_NONE);
+
+        const uint16_t boon_count = BuffRegistry::boonCount();
+        log.generation.assign(log.players.size() * boon_count, 0);
+
+        std::vector<uint64_t> first_aware(log.players.size(), UINT64_MAX);
+        std::vector<uint64_t> last_aware(log.players.size(), 0);
+
+        for (size_t i = 0; i < event_count; ++i) {
+            Parser::decodeEvent(events + i * stride, log.revision, event);
+            uint16_t src = find(event.src_agent);
+            uint16_t dst = find(event.dst_agent);
+
+            if (src != WVW_NONE) {
+                first_aware[src] = std::min(first_aware[src], event.time);
+                last_aware[src] = std::max(last_aware[src], event.time);
+            }
+
+            if (event.is_statechange) {
+                if (event.is_statechange == CBTS_LOGSTART) {
+                    log.log_start = event.time;
+                    log.server_start = (uint32_t)event.value;
+                }
+                else if (event.is_statechange == CBTS_LOGEND) {
+                    log.log_end = event.time;
+                }
+                else if (event.is_statechange == CBTS_CHANGEDOWN && src != WVW_NONE) {
+                    log.players[src].downs++;
+                }
+                else if (event.is_statechange == CBTS_CHANGEDEAD && src != WVW_NONE) {
+                    log.players[src].deaths++;
+                }
+                continue;
+            }
+
+            //Instance ids are reused, so each id only points at the player that used it last
+            if (src != WVW_NONE && event.src_instid && event.src_instid != log.players[src].instance_id) {
+                if (by_instid[log.players[src].instance_id] == src) {
+                    by_instid[log.players[src].instance_id] = WVW_NONE;
+                }
+                log.players[src].instance_id = event.src_instid;
+                by_instid[event.src_instid] = src;
+            }
+            if (event.is_activation || event.is_buffremove) {
+                continue;
+            }
+
+            //Minions count for their master
+            uint16_t attacker = src;
+            if (attacker == WVW_NONE && event.src_master_instid) {
+                attacker = by_instid[event.src_master_instid];
+            }
+
+            if (event.buff) {
+                if (event.buff_dmg > 0) {
+                    if (attacker != WVW_NONE) {
+                        log.players[attacker].condi_damage += (uint32_t)event.buff_dmg;
+                    }
+                    if (dst != WVW_NONE) {
+                        log.players[dst].damage_taken += (uint32_t)event.buff_dmg;
+                    }
+                }
+                else if (event.value > 0 && attacker != WVW_NONE && dst != WVW_NONE) {
+                    uint16_t boon = BuffRegistry::index(event.skillid);
+                    if (boon < boon_count) {
+                        log.generation[(size_t)attacker * boon_count + boon] += BoonGeneration::contributed(event);
+                    }
+                }
+            }
+            else if (event.value > 0) {
+                if (attacker != WVW_NONE) {
+                    WvwPlayer& player = log.players[attacker];
+                    player.damage += (uint32_t)event.value;
+                    if (event.result == CBTR_DOWNED) {
+                        player.downs_dealt++;
+                    }
+                    else if (event.result == CBTR_KILLINGBLOW) {
+                        player.kills++;
+                    }
+                }
+                if (dst != WVW_NONE) {
+                    log.players[dst].damage_taken += (uint32_t)event.value;
+                }
+            }
+        }
+
+        for (size_t i = 0; i < log.players.size(); ++i) {
+            if (first_aware[i] == UINT64_MAX) {
+                continue;
+            }
+            log.players[i].first_aware = first_aware[i] > log.log_start ? (uint32_t)(first_aware[i] - log.log_start) : 0;
+            log.players[i].last_aware = last_aware[i] > log.log_start ? (uint32_t)(last_aware[i] - log.log_start) : 0;
+        }
+
+        log.memory.tracked = log.players.size();
+        log.memory.player_bytes = log.players.capacity() * sizeof(WvwPlayer);
+        log.memory.name_bytes = log.names.capacity();
+        log.memory.generation_bytes = log.generation.capacity() * sizeof(uint32_t);
+        log.memory.index_bytes = by_addr.capacity() * sizeof(by_addr[0]) + by_instid.capacity() * sizeof(uint16_t)
+            + (first_aware.capacity() + last_aware.capacity()) * sizeof(uint64_t);
+        log.valid = true;
+    }
+
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "Revtc.h"
+
+namespace Revtc {
+
+	//Large-scale profile for WvW logs (BossID::WVW). Events are decoded one at a time straight from the
+	//buffer, nothing per event is kept, and only the tracked players get any state, so memory is the input
+	//buffer plus a few hundred bytes per tracked player regardless of how many agents the log holds.
+
+	enum class WvwScope : uint8_t {
+		SQUAD,    // every squad member in the log
+		SUBGROUP, // only the POV's subgroup
+	};
+
+	struct WvwOptions {
+		WvwScope scope = WvwScope::SQUAD;
+	};
+
+	struct WvwPlayer {
+		uint64_t addr;
+		uint32_t name;    // offset into WvwLog::names
+		uint32_t account; // offset into WvwLog::names
+		uint32_t profession;
+		uint32_t elite_spec;
+		uint16_t subgroup;
+		uint16_t instance_id;
+		uint32_t first_aware; // ms after log start
+		uint32_t last_aware;
+		uint64_t damage;       // physical, minions included
+		uint64_t condi_damage; // minions included
+		uint64_t damage_taken;
+		uint32_t downs_dealt; // hits that downed their target
+		uint32_t kills;       // killing blows
+		uint32_t downs;
+		uint32_t deaths;
+	};
+
+	struct WvwMemory {
+		size_t agents;        // agents in the log
+		size_t tracked;       // players with state
+		size_t player_bytes;
+		size_t name_bytes;
+		size_t generation_bytes;
+		size_t index_bytes;   // address and instance id lookups
+		size_t total() const { return player_bytes + name_bytes + generation_bytes + index_bytes; }
+	};
+
+	struct WvwLog {
+		bool valid;
+		std::string error;
+		std::string version;
+		uint8_t revision;
+		uint64_t pov_addr; // 0 if the log has no CBTS_POINTOFVIEW
+		uint16_t pov_subgroup;
+		uint32_t server_start;
+		uint64_t log_start;
+		uint64_t log_end;
+		uint64_t event_count;
+
+		std::vector<WvwPlayer> players; // agent table order
+		std::string names; // NUL terminated character and account names
+		//Outgoing boon generation in ms onto tracked players, [player * BuffRegistry::boonCount() + boon]
+		std::vector<uint32_t> generation;
+		WvwMemory memory;
+
+		const char* name(uint32_t offset) const { return names.c_str() + offset; }
+	};
+
+	class WvwParser
+	{
+	public:
+		WvwOptions options;
+
+		//Like Parser::parse, the Log's containers are reused across calls
+		void parse(const unsigned char* buf, size_t len, WvwLog& log);
+
+	private:
+		std::vector<std::pair<uint64_t, uint16_t>> by_addr; // (addr, player) sorted by addr
+		std::vector<uint16_t> by_instid; // current player of each instance id
+
+		uint16_t find(uint64_t addr) const;
+	};
+
+}
@@ -0,0 +1,80 @@
+//Parses the same log N times on one Parser and Log and reports heap allocations per log after warm-up.
+//  g++ -std=c++17 -O2 -pthread -I.. -I../tests BenchParserReuse.cpp ../Revtc.cpp -o BenchParserReuse
+//  ./BenchParserReuse [file.evtc] [iterations] [threads]
+//Without a file (or with "") a synthetic log is used. Each extra thread costs a few allocations per pass for
+//std::thread itself. With -DREVTC_MEMORY_STATS the per-container report of the last parse is printed too.
+
+#include "Revtc.h"
+#include "SyntheticLog.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <new>
+
+static std::atomic<uint64_t> heap_allocations{ 0 };
+
+void* operator new(size_t size)
+{
+	heap_allocations.fetch_add(1, std::memory_order_relaxed);
+	if (void* p = std::malloc(size ? size : 1)) {
+		return p;
+	}
+	throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+
+int main(int argc, char** argv)
+{
+	std::vector<unsigned char> data;
+	if (argc > 1 && argv[1][0]) {
+		std::ifstream file(argv[1], std::ios::binary);
+		data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+	}
+	else {
+		data = SyntheticLog::make(10, 100000);
+	}
+	const int iterations = argc > 2 ? std::atoi(argv[2]) : 100;
+	const unsigned threads = argc > 3 ? (unsigned)std::atoi(argv[3]) : 1;
+
+	Revtc::Parser parser(nullptr, 0);
+	parser.threads = threads;
+	Revtc::Log log;
+
+	uint64_t before = heap_allocations.load();
+	parser.parse(data.data(), data.size(), log);
+	const uint64_t first = heap_allocations.load() - before;
+	if (!log.valid) {
+		std::printf("invalid log: %s\n", log.error.c_str());
+		return 1;
+	}
+
+	before = heap_allocations.load();
+	auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < iterations; ++i) {
+		parser.parse(data.data(), data.size(), log);
+	}
+	double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	const uint64_t reused = heap_allocations.load() - before;
+
+	std::printf("%zu bytes, %zu players, %d threads\n", data.size(), log.players.size(), threads);
+	std::printf("first parse:  %llu allocations\n", (unsigned long long)first);
+	std::printf("after warm-up: %.2f allocations per log, %.3f ms per log\n", (double)reused / iterations, ms / iterations);
+
+#ifdef REVTC_MEMORY_STATS
+	Revtc::MemoryReport report = parser.memoryReport();
+	std::printf("tracked containers, last parse (%llu events):\n", (unsigned long long)report.events);
+	for (size_t i = 0; i < (size_t)Revtc::MemoryPool::COUNT; ++i) {
+		const Revtc::MemoryUsage& usage = report.pools[i];
+		std::printf("  %-12s %6llu allocations %10llu bytes allocated %10llu peak\n", Revtc::MemoryReport::name((Revtc::MemoryPool)i),
+			(unsigned long long)usage.allocations, (unsigned long long)usage.allocated, (unsigned long long)usage.peak);
+	}
+	std::printf("  %-12s %6llu allocations %10llu bytes allocated %10llu peak\n", "total",
+		(unsigned long long)report.total.allocations, (unsigned long long)report.total.allocated, (unsigned long long)report.total.peak);
+#endif
+	return 0;
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+//Minimal checks for the standalone test programs in this directory. Each test is one executable that
+//returns non-zero if any check failed, e.g.
+//  g++ -std=c++17 -O2 -pthread -I.. TestBoonStacks.cpp ../Revtc.cpp -o TestBoonStacks && ./TestBoonStacks
+
+#include <cstdio>
+#include <cmath>
+
+static int check_failures = 0;
+
+#define CHECK(expr) \
+	do { \
+		if (!(expr)) { \
+			std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #expr); \
+			++check_failures; \
+		} \
+	} while (0)
+
+#define CHECK_NEAR(a, b, eps) CHECK(std::fabs((double)(a) - (double)(b)) <= (eps))
+
+inline int checkResult(const char* name)
+{
+	std::printf("%s: %s\n", name, check_failures ? "FAILED" : "passed");
+	return check_failures ? 1 : 0;
+}
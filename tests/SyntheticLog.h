@@ -0,0 +1,212 @@
+#pragma once
+
+//Builds small EVTC logs in memory for the tests and benchmarks, no log files needed.
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace SyntheticLog {
+
+	struct Writer {
+		std::vector<unsigned char> bytes;
+
+		template<typename T> void put(T value)
+		{
+			size_t offset = bytes.size();
+			bytes.resize(offset + sizeof(T));
+			memcpy(&bytes[offset], &value, sizeof(T));
+		}
+		//Writes text into a zero padded field of size bytes
+		void field(const std::string& text, size_t size)
+		{
+			size_t offset = bytes.size();
+			bytes.resize(offset + size, 0);
+			memcpy(&bytes[offset], text.data(), std::min(text.size(), size));
+		}
+	};
+
+	struct Event {
+		uint64_t time = 0, src = 0, dst = 0;
+		int32_t value = 0, buff_dmg = 0;
+		uint32_t overstack = 0, skillid = 0;
+		uint16_t src_instid = 0, dst_instid = 0, src_master_instid = 0, dst_master_instid = 0;
+		uint8_t iff = 0, buff = 0, result = 0, is_activation = 0, is_buffremove = 0, is_ninety = 0, is_fifty = 0;
+		uint8_t is_moving = 0, is_statechange = 0, is_flanking = 0, is_shields = 0, is_offcycle = 0;
+		uint32_t buff_instid = 0;
+	};
+
+	//Agent table entry that is not a player
+	struct Npc {
+		uint64_t addr;
+		uint16_t species;
+		std::string name;
+	};
+
+	const uint64_t BOSS_ADDR = 1;
+	const uint64_t PLAYER_ADDR = 1000; // players are PLAYER_ADDR + i
+	const uint32_t SKILL_HIT = 5000;
+	const uint32_t SKILLS[] = { 740, 1187, 30328, 725, 736, SKILL_HIT };
+
+	//Revision 1 log of the given boss with players PlayerN (Account N), the boss at BOSS_ADDR, then npcs,
+	//and the events as given
+	inline std::vector<unsigned char> write(int players, uint16_t boss, const std::vector<Event>& events,
+		const std::vector<Npc>& npcs = std::vector<Npc>())
+	{
+		Writer out;
+		out.field("EVTC", 4);
+		out.field("20230101", 8);
+		out.put<uint8_t>(1);
+		out.put<uint16_t>(boss);
+		out.put<uint8_t>(0);
+
+		out.put<uint32_t>((uint32_t)(players + 1 + npcs.size()));
+		for (int i = 0; i < players; ++i) {
+			std::string name = "Player" + std::to_string(i);
+			name.push_back('\0');
+			name += ":Account" + std::to_string(i) + ".1234";
+			name.push_back('\0');
+			name += std::to_string(1 + i % 3);
+			out.put<uint64_t>(PLAYER_ADDR + i);
+			out.put<uint32_t>(1 + i % 9);
+			out.put<uint32_t>(i % 2 ? 62 : 0);
+			for (int k = 0; k < 6; ++k) out.put<int16_t>(0);
+			out.field(name, 64);
+			out.put<uint32_t>(0);
+		}
+		out.put<uint64_t>(BOSS_ADDR);
+		out.put<uint32_t>((uint32_t)boss | (1u << 16));
+		out.put<uint32_t>(0xFFFFFFFF);
+		for (int k = 0; k < 6; ++k) out.put<int16_t>(0);
+		out.field("Boss", 64);
+		out.put<uint32_t>(0);
+		for (const Npc& npc : npcs) {
+			out.put<uint64_t>(npc.addr);
+			out.put<uint32_t>((uint32_t)npc.species | (1u << 16));
+			out.put<uint32_t>(0xFFFFFFFF);
+			for (int k = 0; k < 6; ++k) out.put<int16_t>(0);
+			out.field(npc.name, 64);
+			out.put<uint32_t>(0);
+		}
+
+		out.put<uint32_t>(sizeof(SKILLS) / sizeof(SKILLS[0]));
+		for (uint32_t skill : SKILLS) {
+			out.put<int32_t>(skill);
+			out.field("Skill " + std::to_string(skill), 64);
+		}
+
+		for (const Event& e : events) {
+			out.put(e.time); out.put(e.src); out.put(e.dst); out.put(e.value); out.put(e.buff_dmg);
+			out.put(e.overstack); out.put(e.skillid);
+			out.put(e.src_instid); out.put(e.dst_instid); out.put(e.src_master_instid); out.put(e.dst_master_instid);
+			const uint8_t flags[] = { e.iff, e.buff, e.result, e.is_activation, e.is_buffremove, e.is_ninety, e.is_fifty,
+				e.is_moving, e.is_statechange, e.is_flanking, e.is_shields, e.is_offcycle };
+			for (uint8_t flag : flags) out.put(flag);
+			out.put(e.buff_instid);
+		}
+		return out.bytes;
+	}
+
+	//Log start at time 1000 with server time 1600000000
+	inline Event logStart(uint64_t time = 1000)
+	{
+		Event start;
+		start.time = time;
+		start.src = 0x637261;
+		start.value = 1600000000;
+		start.is_statechange = 9;
+		return start;
+	}
+
+	//Boss death and log end
+	inline void finish(std::vector<Event>& events, uint64_t time)
+	{
+		Event death;
+		death.time = time;
+		death.src = BOSS_ADDR;
+		death.is_statechange = 4;
+		events.push_back(death);
+		Event end = logStart(time + 20);
+		end.value = 1600000100;
+		end.is_statechange = 10;
+		events.push_back(end);
+	}
+
+	//Log of the given boss: players hitting the boss, bleeding, boon applications and removals
+	//and skill casts over hits events, then the boss dies. The same seed gives the same bytes.
+	inline std::vector<unsigned char> make(int players = 5, int hits = 2000, uint16_t boss = 17154, unsigned seed = 1)
+	{
+		const uint32_t* skills = SKILLS;
+		std::mt19937 rng(seed);
+		std::vector<Event> events;
+		events.push_back(logStart());
+
+		uint64_t time = 1000;
+		uint32_t buff_instid = 1;
+		for (int i = 0; i < hits; ++i) {
+			time += 1 + rng() % 40;
+			int p = rng() % players;
+			Event hit;
+			hit.time = time;
+			hit.src = PLAYER_ADDR + p;
+			hit.dst = BOSS_ADDR;
+			hit.src_instid = (uint16_t)(10 + p);
+			hit.dst_instid = 2;
+			hit.value = 100 + rng() % 5000;
+			hit.skillid = SKILL_HIT;
+			hit.result = rng() % 5;
+			events.push_back(hit);
+			if (i % 7 == 0) {
+				Event bleed = hit;
+				bleed.value = 0;
+				bleed.buff = 1;
+				bleed.buff_dmg = 300;
+				bleed.skillid = 736;
+				events.push_back(bleed);
+			}
+			if (i % 3 == 0) {
+				int q = rng() % players;
+				Event boon;
+				boon.time = time;
+				boon.src = PLAYER_ADDR + p;
+				boon.dst = PLAYER_ADDR + q;
+				boon.src_instid = (uint16_t)(10 + p);
+				boon.dst_instid = (uint16_t)(10 + q);
+				boon.buff = 1;
+				boon.value = 2000 + rng() % 8000;
+				boon.skillid = skills[rng() % 4];
+				boon.buff_instid = buff_instid++;
+				events.push_back(boon);
+				if (rng() % 4 == 0) {
+					Event remove;
+					remove.time = time + 300;
+					remove.src = boon.dst;
+					remove.dst = boon.src;
+					remove.skillid = boon.skillid;
+					remove.is_buffremove = 2;
+					remove.buff_instid = boon.buff_instid;
+					events.push_back(remove);
+				}
+			}
+			if (i % 13 == 0) {
+				Event cast;
+				cast.time = time;
+				cast.src = PLAYER_ADDR + p;
+				cast.src_instid = (uint16_t)(10 + p);
+				cast.skillid = SKILL_HIT;
+				cast.is_activation = 1;
+				cast.value = 800;
+				events.push_back(cast);
+				cast.time = time + 600;
+				cast.is_activation = 5;
+				events.push_back(cast);
+			}
+		}
+		finish(events, time + 10);
+		return write(players, boss, events);
+	}
+
+}
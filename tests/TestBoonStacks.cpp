@@ -0,0 +1,60 @@
+#include "Check.h"
+#include "Revtc.h"
+
+using namespace Revtc;
+
+//Replays the stacks of one buff over [1000, 1000 + duration) and returns the stack-milliseconds it integrated
+static double replay(uint32_t buff_id, const std::vector<BoonStack>& stacks, uint64_t duration = 60050)
+{
+	Parser parser(nullptr, 0);
+	parser.buff_tracks.assign(1, Boon{ BuffRegistry::index(buff_id), 0, (uint32_t)stacks.size(), 0.f });
+	parser.buff_stacks.assign(stacks.begin(), stacks.end());
+	parser.replay_boons(1000, duration);
+	return (double)parser.buff_tracks[0].average * duration;
+}
+
+static BoonStack clear(uint64_t time, uint32_t buff_instid) { return BoonStack(time, 0, false, buff_instid, true); }
+
+int main()
+{
+	const uint32_t QUICKNESS = 1187;
+	const uint32_t MIGHT = 740;
+
+	//Duration stacks queue, back-to-back applications add up
+	CHECK_NEAR(replay(QUICKNESS, { BoonStack(1000, 5000), BoonStack(2000, 5000) }), 10000, 1);
+	//A longer stack takes over and the paused one finishes afterwards
+	CHECK_NEAR(replay(QUICKNESS, { BoonStack(1000, 5000), BoonStack(2000, 8000) }), 13000, 1);
+	//Gaps still count as down
+	CHECK_NEAR(replay(QUICKNESS, { BoonStack(1000, 2000), BoonStack(10000, 3000) }), 5000, 1);
+	//Quickness queues at most 5 stacks, a sixth that is not longer than any is dropped
+	CHECK_NEAR(replay(QUICKNESS, std::vector<BoonStack>(6, BoonStack(1000, 5000))), 25000, 1);
+	//...and a longer one replaces the shortest
+	{
+		std::vector<BoonStack> stacks(5, BoonStack(1000, 5000));
+		stacks.push_back(BoonStack(1000, 9000));
+		CHECK_NEAR(replay(QUICKNESS, stacks), 29000, 1);
+	}
+	//Removing the ticking stack lets the next one run
+	CHECK_NEAR(replay(QUICKNESS, { BoonStack(1000, 5000, false, 1), BoonStack(1000, 5000, false, 2), clear(3000, 1) }), 7000, 1);
+	//Extending a waiting stack lengthens the total
+	CHECK_NEAR(replay(QUICKNESS, { BoonStack(1000, 5000, false, 1), BoonStack(1000, 4000, false, 2), BoonStack(2000, 3000, true, 2) }), 12000, 1);
+	//Uptime stops at the end of the window
+	CHECK_NEAR(replay(QUICKNESS, { BoonStack(1000, 30000), BoonStack(1000, 30000) }, 40050), 40000, 1);
+
+	//Intensity stacks run side by side
+	CHECK_NEAR(replay(MIGHT, { BoonStack(1000, 5000), BoonStack(2000, 5000) }), 10000, 1);
+	//Over 25 stacks of might the one that ends first is dropped
+	{
+		std::vector<BoonStack> stacks(25, BoonStack(1000, 10000));
+		stacks.push_back(BoonStack(2000, 20000));
+		CHECK_NEAR(replay(MIGHT, stacks), 24 * 10000 + 1000 + 20000, 1);
+	}
+	//...unless the new stack would end first
+	{
+		std::vector<BoonStack> stacks(25, BoonStack(1000, 10000));
+		stacks.push_back(BoonStack(2000, 5000));
+		CHECK_NEAR(replay(MIGHT, stacks), 25 * 10000, 1);
+	}
+
+	return checkResult("TestBoonStacks");
+}
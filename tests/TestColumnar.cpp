@@ -0,0 +1,113 @@
+#include "Check.h"
+#include "SyntheticLog.h"
+#include "RevtcColumnar.h"
+#include <algorithm>
+
+using namespace Revtc;
+
+static bool sameEvent(const CombatEvent& lhs, const CombatEvent& rhs)
+{
+	return lhs.time == rhs.time && lhs.src_agent == rhs.src_agent && lhs.dst_agent == rhs.dst_agent
+		&& lhs.value == rhs.value && lhs.buff_dmg == rhs.buff_dmg && lhs.overstack_value == rhs.overstack_value
+		&& lhs.skillid == rhs.skillid && lhs.src_instid == rhs.src_instid && lhs.dst_instid == rhs.dst_instid
+		&& lhs.src_master_instid == rhs.src_master_instid && lhs.dst_master_instid == rhs.dst_master_instid
+		&& lhs.iff == rhs.iff && lhs.buff == rhs.buff && lhs.result == rhs.result && lhs.is_activation == rhs.is_activation
+		&& lhs.is_buffremove == rhs.is_buffremove && lhs.is_ninety == rhs.is_ninety && lhs.is_fifty == rhs.is_fifty
+		&& lhs.is_moving == rhs.is_moving && lhs.is_statechange == rhs.is_statechange && lhs.is_flanking == rhs.is_flanking
+		&& lhs.is_shields == rhs.is_shields && lhs.is_offcycle == rhs.is_offcycle && lhs.buff_instid == rhs.buff_instid;
+}
+
+//Writes the parser's events with options, reads them back and compares everything
+static void roundTrip(const Parser& parser, const ColumnarOptions& options)
+{
+	std::FILE* file = std::tmpfile();
+	CHECK(file != nullptr);
+	if (!file) {
+		return;
+	}
+	CHECK(writeColumnar(parser, file, options));
+	std::rewind(file);
+
+	ColumnarReader reader(file);
+	CHECK(reader.begin());
+	CHECK(reader.version == COLUMNAR_VERSION);
+	CHECK(reader.block_rows == options.block_rows);
+	CHECK(reader.agents.size() == parser.agents.size());
+	for (const ColumnarAgent& agent : reader.agents) {
+		auto it = parser.agents.find(agent.addr);
+		CHECK(it != parser.agents.end() && it->second.prof == agent.prof && it->second.is_elite == agent.is_elite
+			&& it->second.name == agent.name);
+	}
+	CHECK(reader.skills.size() == parser.skills.size());
+	for (const Skill& skill : reader.skills) {
+		auto it = parser.skills.find(skill.id);
+		CHECK(it != parser.skills.end() && it->second.name == skill.name);
+	}
+
+	std::vector<CombatEvent> block;
+	size_t row = 0;
+	bool same = true;
+	while (reader.next(block)) {
+		CHECK(block.size() <= options.block_rows);
+		for (const CombatEvent& event : block) {
+			same = same && row < parser.events.size() && sameEvent(event, parser.events[row]);
+			++row;
+		}
+	}
+	CHECK(reader.ok());
+	CHECK(same);
+	CHECK(row == parser.events.size());
+	std::fclose(file);
+}
+
+int main()
+{
+	std::vector<unsigned char> bytes = SyntheticLog::make(5, 5000);
+	Parser parser(bytes.data(), bytes.size());
+	Log log = parser.parse();
+	CHECK(log.valid);
+
+	//An address outside the agent table goes through the DICT exception list
+	CombatEvent stray = parser.events.back();
+	stray.src_agent = 0xDEADBEEF;
+	stray.dst_agent = 0xFEEDFACE;
+	parser.events.push_back(stray);
+
+	ColumnarOptions options;
+	roundTrip(parser, options);
+	options.block_rows = 1000;
+	roundTrip(parser, options);
+	options.block_rows = 1;
+	roundTrip(parser, options);
+	options.block_rows = 777;
+	options.encode = false;
+	roundTrip(parser, options);
+
+	//A file cut short is an error, not a shorter event list
+	std::FILE* file = std::tmpfile();
+	options = ColumnarOptions();
+	options.block_rows = 1000;
+	CHECK(file && writeColumnar(parser, file, options));
+	if (file) {
+		long size = std::ftell(file);
+		std::vector<unsigned char> data(size);
+		std::rewind(file);
+		CHECK(std::fread(data.data(), 1, data.size(), file) == data.size());
+		std::fclose(file);
+		for (long cut : { size - 1, size / 2, size / 3 }) {
+			std::FILE* partial = std::tmpfile();
+			std::fwrite(data.data(), 1, cut, partial);
+			std::rewind(partial);
+			ColumnarReader reader(partial);
+			std::vector<CombatEvent> block;
+			if (reader.begin()) {
+				while (reader.next(block)) {
+				}
+			}
+			CHECK(!reader.ok());
+			std::fclose(partial);
+		}
+	}
+
+	return checkResult("TestColumnar");
+}
@@ -0,0 +1,104 @@
+#include "Check.h"
+#include "SyntheticLog.h"
+#include "RevtcC.h"
+#include "RevtcJson.h"
+#include <string>
+
+using namespace Revtc;
+using SyntheticLog::Event;
+using SyntheticLog::BOSS_ADDR;
+using SyntheticLog::PLAYER_ADDR;
+
+static Event statechange(uint64_t time, uint64_t src, uint64_t dst, uint8_t kind)
+{
+	Event event;
+	event.time = time;
+	event.src = src;
+	event.dst = dst;
+	event.src_instid = src == BOSS_ADDR ? 2 : (uint16_t)(10 + src - PLAYER_ADDR);
+	event.is_statechange = kind;
+	return event;
+}
+
+static bool contains(const std::string& text, const std::string& part)
+{
+	return text.find(part) != std::string::npos;
+}
+
+int main()
+{
+	std::vector<Event> events;
+	events.push_back(SyntheticLog::logStart());
+	events.push_back(statechange(1000, BOSS_ADDR, 22021440, CBTS_MAXHEALTHUPDATE));
+	events.push_back(statechange(3000, BOSS_ADDR, 7500, CBTS_HEALTHUPDATE));
+	events.push_back(statechange(6000, BOSS_ADDR, 2500, CBTS_HEALTHUPDATE));
+	events.push_back(statechange(7000, PLAYER_ADDR + 1, 0, CBTS_CHANGEDOWN));
+
+	Event cast;
+	cast.time = 2000;
+	cast.src = PLAYER_ADDR;
+	cast.src_instid = 10;
+	cast.skillid = SyntheticLog::SKILL_HIT;
+	cast.is_activation = 1;
+	cast.value = 800;
+	events.push_back(cast);
+	cast.time = 2600;
+	cast.is_activation = 5; // ACTV_RESET
+	events.push_back(cast);
+
+	Event hit;
+	hit.time = 4000;
+	hit.src = BOSS_ADDR;
+	hit.dst = PLAYER_ADDR + 1;
+	hit.src_instid = 2;
+	hit.dst_instid = 11;
+	hit.skillid = SyntheticLog::SKILL_HIT;
+	hit.value = 1234;
+	events.push_back(hit);
+	SyntheticLog::finish(events, 9000);
+	std::vector<unsigned char> bytes = SyntheticLog::write(2, 17154, events);
+
+	Parser parser(bytes.data(), bytes.size());
+	Log log = parser.parse();
+	CHECK(log.valid);
+	CHECK(log.boss_health.size() == 1);
+	CHECK(log.boss_health[0].points.size() == 2);
+	CHECK(log.boss_health[0].max_health.size() == 1);
+
+	//JSON carries casts, defense, damage taken by skill and the boss health
+	std::string json(writeJson(log, nullptr, 0, JsonOptions(), &parser), '\0');
+	writeJson(log, &json[0], json.size(), JsonOptions(), &parser);
+	CHECK(contains(json, "\"casts\":[{\"start\":1000,\"duration\":600,\"skill_id\":5000,\"outcome\":\"completed\",\"quickness\":false}]"));
+	CHECK(contains(json, "\"defense\":{\"damage_taken\":1234,\"barrier_absorbed\":0,\"downs\":1,"));
+	CHECK(contains(json, "\"damage_taken_by_skill\":[{\"skill_id\":5000,\"damage\":1234,\"barrier\":0,\"hits\":1}]"));
+	const HealthTimeline& timeline = log.boss_health[0];
+	std::string health = "\"boss_health\":[{\"addr\":1,\"species_id\":17154,\"points\":[["
+		+ std::to_string(timeline.points[0].time) + "," + std::to_string(timeline.points[0].percent) + "],["
+		+ std::to_string(timeline.points[1].time) + "," + std::to_string(timeline.points[1].percent) + "]],\"max_health\":[["
+		+ std::to_string(timeline.max_health[0].time) + ",22021440]]}]";
+	CHECK(contains(json, health));
+
+	//The flat C block carries the same boss health
+	const revtc_header* flat = revtc_parse(bytes.data(), bytes.size());
+	CHECK(flat != nullptr);
+	if (flat) {
+		const uint8_t* block = (const uint8_t*)flat;
+		CHECK(flat->version == REVTC_FLAT_VERSION);
+		CHECK(flat->boss_health_count == 1);
+		CHECK(flat->boss_health_size == sizeof(revtc_health));
+		const revtc_health* out = (const revtc_health*)(block + flat->boss_health);
+		CHECK(out->addr == BOSS_ADDR && out->species_id == 17154);
+		CHECK(out->point_count == timeline.points.size());
+		const revtc_health_point* points = (const revtc_health_point*)(block + out->points);
+		for (uint32_t i = 0; i < out->point_count && i < timeline.points.size(); ++i) {
+			CHECK(points[i].time == timeline.points[i].time && points[i].percent == timeline.points[i].percent);
+		}
+		CHECK(out->max_health_count == 1);
+		const revtc_max_health* max_health = (const revtc_max_health*)(block + out->max_health);
+		CHECK(max_health[0].time == timeline.max_health[0].time && max_health[0].value == 22021440);
+		CHECK(out->max_health + sizeof(revtc_max_health) <= flat->strings);
+		revtc_free(flat);
+	}
+
+	return checkResult("TestExport");
+}
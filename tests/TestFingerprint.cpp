@@ -0,0 +1,101 @@
+#include "Check.h"
+#include "SyntheticLog.h"
+#include "RevtcFingerprint.h"
+#include <algorithm>
+
+using namespace Revtc;
+using SyntheticLog::Event;
+
+//Direct hits of the squad on the boss, each with its own damage
+static std::vector<Event> fight(int players, int hits, unsigned seed)
+{
+	std::mt19937 rng(seed);
+	std::vector<Event> events;
+	uint64_t time = 1000;
+	for (int i = 0; i < hits; ++i) {
+		time += 1 + rng() % 40;
+		int p = rng() % players;
+		Event hit;
+		hit.time = time;
+		hit.src = SyntheticLog::PLAYER_ADDR + p;
+		hit.dst = SyntheticLog::BOSS_ADDR;
+		hit.src_instid = (uint16_t)(10 + p);
+		hit.dst_instid = 2;
+		hit.value = 100 + rng() % 50000;
+		hit.skillid = SyntheticLog::SKILLS[rng() % 6];
+		events.push_back(hit);
+	}
+	return events;
+}
+
+static Fingerprint fingerprintOf(const std::vector<Event>& hits, uint64_t local_start, int32_t server_skew)
+{
+	std::vector<Event> events;
+	Event start = SyntheticLog::logStart(local_start);
+	start.value += server_skew;
+	events.push_back(start);
+	for (Event hit : hits) {
+		hit.time += local_start;
+		events.push_back(hit);
+	}
+	SyntheticLog::finish(events, events.back().time + 10);
+	std::vector<unsigned char> bytes = SyntheticLog::write(5, 17154, events);
+	return fingerprint(bytes.data(), bytes.size());
+}
+
+int main()
+{
+	std::vector<Event> hits = fight(5, 20000, 1);
+	Fingerprint a = fingerprintOf(hits, 1000, 0);
+	CHECK(a.valid);
+	CHECK(a.player_count == 5);
+	CHECK(a.sample_count == FINGERPRINT_SAMPLES);
+
+	//Another POV: other local clock, LOGSTART a few seconds later, hits recorded in a different order
+	//and some of them missed
+	std::vector<Event> other;
+	std::mt19937 rng(37);
+	for (size_t i = 0; i < hits.size(); ++i) {
+		if (rng() % 10 == 0) continue;
+		other.push_back(hits[i]);
+		if (other.size() >= 2 && rng() % 2) {
+			std::swap(other[other.size() - 1], other[other.size() - 2]);
+		}
+	}
+	Fingerprint b = fingerprintOf(other, 987654, 3);
+	CHECK(b.valid);
+	CHECK(b.roster == a.roster);
+	CHECK(b.matches(a) && a.matches(b));
+	CHECK(a.overlap(b) >= 0.75f);
+	CHECK(a.key() == b.key() || a.key(-1) == b.key() || a.key(1) == b.key());
+
+	//The order of the hits alone does not change the sample
+	std::vector<Event> reversed(hits.rbegin(), hits.rend());
+	Fingerprint c = fingerprintOf(reversed, 1000, 0);
+	CHECK(c.sample_count == a.sample_count);
+	CHECK(std::equal(a.samples, a.samples + a.sample_count, c.samples));
+
+	//Another fight of the same squad and boss around the same time
+	Fingerprint d = fingerprintOf(fight(5, 20000, 2), 1000, 30);
+	CHECK(d.roster == a.roster);
+	CHECK(!d.matches(a));
+	CHECK(a.overlap(d) < 0.25f);
+
+	//Events past the scan limit are not read
+	std::vector<Event> longer = hits;
+	std::vector<Event> tail = fight(5, FINGERPRINT_SCAN_EVENTS, 3);
+	for (Event& hit : tail) {
+		hit.time += hits.back().time;
+	}
+	longer.insert(longer.end(), tail.begin(), tail.end());
+	std::vector<Event> prefix(longer.begin(), longer.begin() + (FINGERPRINT_SCAN_EVENTS - 1)); // LOGSTART is event 0
+	Fingerprint e = fingerprintOf(longer, 1000, 0);
+	Fingerprint f = fingerprintOf(prefix, 1000, 0);
+	CHECK(e.sample_count == f.sample_count);
+	CHECK(std::equal(e.samples, e.samples + e.sample_count, f.samples));
+
+	//Truncated files never read past the end
+	CHECK(!fingerprint((const unsigned char*)"EVTC", 4).valid);
+
+	return checkResult("TestFingerprint");
+}
@@ -0,0 +1,102 @@
+#include "Check.h"
+#include "SyntheticLog.h"
+#include "Revtc.h"
+#include "RevtcWvw.h"
+
+using namespace Revtc;
+using SyntheticLog::Event;
+using SyntheticLog::PLAYER_ADDR;
+
+static const uint32_t QUICKNESS = 1187;
+static const uint32_t MIGHT = 740;
+
+//Buff application of skill from player src onto player dst
+static Event apply(uint64_t time, int src, int dst, uint32_t skill, int32_t value, uint32_t overstack, uint32_t buff_instid)
+{
+	Event event;
+	event.time = time;
+	event.src = PLAYER_ADDR + src;
+	event.dst = PLAYER_ADDR + dst;
+	event.src_instid = (uint16_t)(10 + src);
+	event.dst_instid = (uint16_t)(10 + dst);
+	event.skillid = skill;
+	event.buff = 1;
+	event.value = value;
+	event.overstack = overstack;
+	event.buff_instid = buff_instid;
+	return event;
+}
+
+static Event extend(uint64_t time, int src, int dst, uint32_t skill, int32_t value, uint32_t buff_instid)
+{
+	Event event = apply(time, src, dst, skill, value, 0, buff_instid);
+	event.is_offcycle = 1;
+	//Extensions carry the new duration here, it must not count as overstack
+	event.overstack = 99999;
+	return event;
+}
+
+int main()
+{
+	std::vector<Event> events;
+	events.push_back(SyntheticLog::logStart());
+	events.push_back(apply(2000, 0, 0, QUICKNESS, 5000, 0, 1));    // self-application
+	events.push_back(apply(2000, 0, 1, QUICKNESS, 4000, 1500, 2)); // 1500 overstacked
+	events.push_back(extend(3000, 2, 1, QUICKNESS, 2000, 2));      // player 2 extends player 1's stack
+	events.push_back(extend(3500, 1, 1, QUICKNESS, 1000, 2));      // player 1 extends its own
+	events.push_back(apply(4000, 1, 0, MIGHT, 8000, 0, 3));
+	events.push_back(apply(4000, 1, 0, MIGHT, 0, 0, 4));           // zero value, not an application
+	SyntheticLog::finish(events, 20000);
+	std::vector<unsigned char> bytes = SyntheticLog::write(3, 17154, events);
+
+	Parser parser(bytes.data(), bytes.size());
+	Log log = parser.parse();
+	CHECK(log.valid);
+	CHECK(log.generation.player_count == 3);
+
+	//Slots follow the agent table, players are sorted differently in log.players
+	uint16_t slot[3] = { 0, 0, 0 };
+	for (const Player& player : log.players) {
+		slot[player.addr - PLAYER_ADDR] = player.slot;
+	}
+	const uint16_t quickness = BuffRegistry::index(QUICKNESS);
+	const uint16_t might = BuffRegistry::index(MIGHT);
+	CHECK(quickness < log.generation.boon_count && might < log.generation.boon_count);
+
+	CHECK(log.generation.at(slot[0], slot[0], quickness) == 5000);
+	CHECK(log.generation.at(slot[0], slot[1], quickness) == 2500);
+	CHECK(log.generation.at(slot[2], slot[1], quickness) == 2000);
+	CHECK(log.generation.at(slot[1], slot[1], quickness) == 1000);
+	CHECK(log.generation.at(slot[1], slot[0], might) == 8000);
+	uint64_t total = 0;
+	for (uint32_t ms : log.generation.ms) {
+		total += ms;
+	}
+	CHECK(total == 5000 + 2500 + 2000 + 1000 + 8000);
+
+	//The same events as a WvW log: Parser has no boss to require, and the WvW profile credits the same ms
+	std::vector<unsigned char> wvw_bytes = SyntheticLog::write(3, (uint16_t)BossID::WVW, events);
+	Log wvw = Parser(wvw_bytes.data(), wvw_bytes.size()).parse();
+	CHECK(wvw.valid);
+	CHECK(wvw.boss_lifetime == 0);
+	CHECK(wvw.generation.ms == log.generation.ms);
+
+	WvwParser wvw_parser;
+	WvwLog profile;
+	wvw_parser.parse(wvw_bytes.data(), wvw_bytes.size(), profile);
+	CHECK(profile.valid);
+	CHECK(profile.players.size() == 3);
+	const uint16_t boon_count = BuffRegistry::boonCount();
+	for (const WvwPlayer& player : profile.players) {
+		const uint16_t src = slot[player.addr - PLAYER_ADDR];
+		for (uint16_t boon = 0; boon < boon_count; ++boon) {
+			uint64_t outgoing = 0;
+			for (uint16_t dst = 0; dst < log.generation.player_count; ++dst) {
+				outgoing += log.generation.at(src, dst, boon);
+			}
+			CHECK(profile.generation[(size_t)(&player - profile.players.data()) * boon_count + boon] == outgoing);
+		}
+	}
+
+	return checkResult("TestGeneration");
+}
@@ -0,0 +1,117 @@
+#include "Check.h"
+#include "SyntheticLog.h"
+#include "Revtc.h"
+#include <algorithm>
+
+using namespace Revtc;
+using SyntheticLog::Event;
+using SyntheticLog::PLAYER_ADDR;
+
+static Event hit(uint64_t time, uint64_t src, uint16_t src_instid, uint16_t master_instid)
+{
+	Event event;
+	event.time = time;
+	event.src = src;
+	event.dst = SyntheticLog::BOSS_ADDR;
+	event.src_instid = src_instid;
+	event.dst_instid = 2;
+	event.src_master_instid = master_instid;
+	event.skillid = SyntheticLog::SKILL_HIT;
+	event.value = 100;
+	return event;
+}
+
+static bool hasSlave(const Log& log, uint64_t master, uint64_t slave)
+{
+	for (const Player& player : log.players) {
+		if (player.addr == master) {
+			return std::binary_search(player.slaves.begin(), player.slaves.end(), slave);
+		}
+	}
+	return false;
+}
+
+int main()
+{
+	//Two holders of id 7 that meet at 200, and one id 9 holder
+	for (int order = 0; order < 2; ++order) {
+		InstanceMap map;
+		if (order == 0) {
+			map.add(7, 100, 200, 1);
+			map.add(7, 200, 300, 2);
+			map.add(9, 150, 150, 3);
+		}
+		else {
+			map.add(9, 150, 150, 3);
+			map.add(7, 200, 300, 2);
+			map.add(7, 100, 200, 1);
+		}
+		map.build();
+		CHECK(map.find(7, 99) == 0);
+		CHECK(map.find(7, 100) == 1); // both ends are inclusive
+		CHECK(map.find(7, 199) == 1);
+		CHECK(map.find(7, 200) == 2); // the later holder wins where they meet
+		CHECK(map.find(7, 300) == 2);
+		CHECK(map.find(7, 301) == 0);
+		CHECK(map.find(9, 149) == 0);
+		CHECK(map.find(9, 150) == 3);
+		CHECK(map.find(9, 151) == 0);
+		CHECK(map.find(8, 150) == 0);
+		CHECK(map.find(6, 150) == 0);
+	}
+
+	//Holders that took an id at the same time resolve the same whatever the add order
+	InstanceMap tied_a;
+	tied_a.add(4, 10, 20, 50);
+	tied_a.add(4, 10, 30, 40);
+	tied_a.build();
+	InstanceMap tied_b;
+	tied_b.add(4, 10, 30, 40);
+	tied_b.add(4, 10, 20, 50);
+	tied_b.build();
+	CHECK(tied_a.find(4, 15) == tied_b.find(4, 15));
+
+	//Player 0 holds id 10 from 1000, switches to id 30 at 5200, then player 1 takes id 10 at 6000.
+	//Each minion names its master by id at a different time.
+	const uint64_t p0 = PLAYER_ADDR;
+	const uint64_t p1 = PLAYER_ADDR + 1;
+	std::vector<Event> events;
+	events.push_back(SyntheticLog::logStart(900));
+	events.push_back(hit(1000, p0, 10, 0));
+	events.push_back(hit(1000, 2000, 100, 10)); // at player 0's first event
+	events.push_back(hit(3000, 2001, 101, 10)); // while player 0 holds 10, before it switches ids
+	events.push_back(hit(5000, p0, 10, 0));
+	events.push_back(hit(5200, p0, 30, 0));
+	events.push_back(hit(5500, 2002, 102, 30)); // player 0's second id
+	events.push_back(hit(5600, 2003, 103, 10)); // id 10 is free here
+	events.push_back(hit(6000, p1, 10, 0));
+	events.push_back(hit(6000, 2004, 104, 10)); // at player 1's first event
+	events.push_back(hit(7000, p0, 30, 0));
+	events.push_back(hit(8000, 2005, 105, 10));
+	events.push_back(hit(9000, p1, 10, 0));
+	SyntheticLog::finish(events, 9500);
+	std::vector<SyntheticLog::Npc> npcs;
+	for (uint64_t addr = 2000; addr <= 2005; ++addr) {
+		npcs.push_back(SyntheticLog::Npc{ addr, 6000, "Minion" });
+	}
+	std::vector<unsigned char> bytes = SyntheticLog::write(2, 17154, events, npcs);
+
+	for (unsigned threads : { 1u, 2u }) {
+		Parser parser(bytes.data(), bytes.size());
+		parser.threads = threads;
+		Log log = parser.parse();
+		CHECK(log.valid);
+		CHECK(parser.instances.find(10, 3000) == p0);
+		CHECK(parser.instances.find(30, 5200) == p0);
+		CHECK(parser.instances.find(10, 6000) == p1);
+		CHECK(hasSlave(log, p0, 2000));
+		CHECK(hasSlave(log, p0, 2001));
+		CHECK(hasSlave(log, p0, 2002));
+		CHECK(!hasSlave(log, p0, 2003) && !hasSlave(log, p1, 2003));
+		CHECK(hasSlave(log, p1, 2004));
+		CHECK(hasSlave(log, p1, 2005));
+		CHECK(!hasSlave(log, p0, 2004) && !hasSlave(log, p0, 2005));
+	}
+
+	return checkResult("TestInstances");
+}
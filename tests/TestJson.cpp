@@ -0,0 +1,47 @@
+#include "Check.h"
+#include "SyntheticLog.h"
+#include "RevtcJson.h"
+#include <string>
+
+using namespace Revtc;
+
+//The encounter name as written by the JSON writer, quotes and escapes included
+static std::string written(Log& log, const std::string& name)
+{
+	log.encounter_name = name;
+	std::string out(writeJson(log, nullptr, 0, JsonOptions{ false, false }), '\0');
+	writeJson(log, &out[0], out.size(), JsonOptions{ false, false });
+	const std::string key = "\"encounter_name\":";
+	size_t begin = out.find(key) + key.size();
+	size_t end = out.find(",\"valid\"", begin);
+	return out.substr(begin, end - begin);
+}
+
+int main()
+{
+	std::vector<unsigned char> bytes = SyntheticLog::make(2, 100);
+	Parser parser(bytes.data(), bytes.size());
+	Log log = parser.parse();
+	CHECK(log.valid);
+
+	//Escapes and well-formed UTF-8 pass through unchanged
+	CHECK(written(log, "Vale Guardian") == "\"Vale Guardian\"");
+	CHECK(written(log, "a\"b\\c\n\x01") == "\"a\\\"b\\\\c\\n\\u0001\"");
+	CHECK(written(log, "K\xC3\xA4rt \xE2\x82\xAC \xF0\x9F\x98\x80 \xEF\xBF\xBF \xF4\x8F\xBF\xBF")
+		== "\"K\xC3\xA4rt \xE2\x82\xAC \xF0\x9F\x98\x80 \xEF\xBF\xBF \xF4\x8F\xBF\xBF\"");
+
+	//Each maximal ill-formed subpart becomes one U+FFFD
+	const std::string fffd = "\xEF\xBF\xBD";
+	CHECK(written(log, "a\x80z") == "\"a" + fffd + "z\"");                     // lone continuation byte
+	CHECK(written(log, "a\xC3z") == "\"a" + fffd + "z\"");                     // missing continuation
+	CHECK(written(log, "a\xE2\x82z") == "\"a" + fffd + "z\"");                 // truncated three byte sequence
+	CHECK(written(log, "a\xE2\x82") == "\"a" + fffd + "\"");                   // truncated at the end
+	CHECK(written(log, "\xC0\xAF") == "\"" + fffd + fffd + "\"");              // overlong, C0 is never valid
+	CHECK(written(log, "\xE0\x80\xAF") == "\"" + fffd + fffd + fffd + "\"");   // overlong three byte
+	CHECK(written(log, "\xED\xA0\x80") == "\"" + fffd + fffd + fffd + "\"");   // surrogate
+	CHECK(written(log, "\xF4\x90\x80\x80") == "\"" + fffd + fffd + fffd + fffd + "\""); // past U+10FFFF
+	CHECK(written(log, "\xF5\xFF") == "\"" + fffd + fffd + "\"");
+	CHECK(written(log, "\xF0\x9F\x98\"") == "\"" + fffd + "\\\"\"");
+
+	return checkResult("TestJson");
+}
@@ -0,0 +1,135 @@
+#include "Check.h"
+#include "RevtcLeaderboard.h"
+#include <algorithm>
+#include <random>
+
+using namespace Revtc;
+
+static bool sameEntry(const LeaderboardEntry& lhs, const LeaderboardEntry& rhs)
+{
+	return lhs.boss_dps == rhs.boss_dps && lhs.account == rhs.account && lhs.log_id == rhs.log_id;
+}
+
+//Rank order written out independently of Board::before
+static bool rankedBefore(const LeaderboardEntry& lhs, const LeaderboardEntry& rhs)
+{
+	if (lhs.boss_dps != rhs.boss_dps) return lhs.boss_dps > rhs.boss_dps;
+	if (lhs.log_id != rhs.log_id) return lhs.log_id < rhs.log_id;
+	return lhs.account < rhs.account;
+}
+
+//Every query of board against the same entries kept as a sorted vector
+static void checkBoard(const Board& board, const std::vector<LeaderboardEntry>& sorted, std::mt19937& rng)
+{
+	CHECK(board.size() == sorted.size());
+	CHECK(board.valid());
+	for (size_t i = 0; i < sorted.size(); ++i) {
+		CHECK(sameEntry(board.at(i + 1), sorted[i]));
+		CHECK(board.rankOf(sorted[i]) == i + 1);
+	}
+	CHECK(board.rankOf(LeaderboardEntry{ 1, 0, UINT64_MAX }) == 0);
+
+	for (int i = 0; i < 50; ++i) {
+		uint32_t boss_dps = rng() % 1200;
+		size_t above = std::count_if(sorted.begin(), sorted.end(),
+			[boss_dps](const LeaderboardEntry& entry) { return entry.boss_dps > boss_dps; });
+		CHECK(board.rank(boss_dps) == above + 1);
+	}
+
+	std::vector<LeaderboardEntry> top;
+	for (size_t k : { (size_t)0, (size_t)1, (size_t)7, sorted.size(), sorted.size() + 5 }) {
+		board.top(k, top);
+		CHECK(top.size() == std::min(k, sorted.size()));
+		for (size_t i = 0; i < top.size(); ++i) {
+			CHECK(sameEntry(top[i], sorted[i]));
+		}
+	}
+}
+
+int main()
+{
+	std::mt19937 rng(47);
+
+	//Random inserts with many boss dps ties, checked against a sorted vector as the board grows
+	Board board;
+	std::vector<LeaderboardEntry> sorted;
+	for (uint64_t i = 0; i < 3000; ++i) {
+		LeaderboardEntry entry{ 1 + (uint32_t)(rng() % 1000), (uint32_t)(rng() % 40), i * 7919 % 3001 };
+		board.insert(entry);
+		sorted.insert(std::upper_bound(sorted.begin(), sorted.end(), entry, rankedBefore), entry);
+		if (i % 300 == 0) {
+			checkBoard(board, sorted, rng);
+		}
+	}
+	checkBoard(board, sorted, rng);
+
+	//The same entries through a Leaderboard, spread over several boards
+	Leaderboard leaderboard;
+	std::map<BoardKey, std::vector<LeaderboardEntry>> expected;
+	for (uint64_t log_id = 0; log_id < 2000; ++log_id) {
+		BoardKey key{ log_id % 3 ? BossID::VALE_GUARDIAN : BossID::GORSEVAL, 1 + (uint32_t)(rng() % 2), 0, 2800 };
+		uint32_t account = rng() % 40;
+		uint32_t boss_dps = 1 + rng() % 1000;
+		//Account indices are handed out in order of first appearance
+		std::string name = "Account" + std::to_string(account) + ".1234";
+		leaderboard.add(key, name, boss_dps, log_id);
+		uint32_t index = 0;
+		while (leaderboard.account(index) != name) {
+			++index;
+		}
+		LeaderboardEntry entry{ boss_dps, index, log_id };
+		std::vector<LeaderboardEntry>& board_sorted = expected[key];
+		board_sorted.insert(std::upper_bound(board_sorted.begin(), board_sorted.end(), entry, rankedBefore), entry);
+	}
+	CHECK(leaderboard.boards().size() == expected.size());
+	for (const auto& expected_pair : expected) {
+		const Board* found = leaderboard.find(expected_pair.first);
+		CHECK(found != nullptr);
+		if (found) {
+			checkBoard(*found, expected_pair.second, rng);
+		}
+	}
+
+	//Snapshot round trip, deserialize rebuilds each board with the linear Board::assign
+	std::vector<uint8_t> snapshot;
+	leaderboard.serialize(snapshot);
+	Leaderboard restored;
+	CHECK(restored.deserialize(snapshot.data(), snapshot.size()));
+	CHECK(restored.accountCount() == leaderboard.accountCount());
+	CHECK(restored.boards().size() == expected.size());
+	for (const auto& expected_pair : expected) {
+		const Board* found = restored.find(expected_pair.first);
+		CHECK(found != nullptr);
+		if (found) {
+			checkBoard(*found, expected_pair.second, rng);
+		}
+	}
+	std::vector<uint8_t> again;
+	restored.serialize(again);
+	CHECK(again == snapshot);
+
+	//A rebuilt board takes further inserts like one built by inserting
+	for (uint64_t log_id = 2000; log_id < 2500; ++log_id) {
+		const BoardKey key{ BossID::VALE_GUARDIAN, 1, 0, 2800 };
+		LeaderboardEntry entry{ 1 + (uint32_t)(rng() % 1000), (uint32_t)(rng() % restored.accountCount()), log_id };
+		restored.add(key, restored.account(entry.account), entry.boss_dps, entry.log_id);
+		std::vector<LeaderboardEntry>& board_sorted = expected[key];
+		board_sorted.insert(std::upper_bound(board_sorted.begin(), board_sorted.end(), entry, rankedBefore), entry);
+	}
+	for (const auto& expected_pair : expected) {
+		checkBoard(*restored.find(expected_pair.first), expected_pair.second, rng);
+	}
+
+	//Truncated or unsupported snapshots are rejected and leave the leaderboard empty
+	for (size_t len = 0; len < snapshot.size(); len += 1 + len / 8) {
+		Leaderboard partial;
+		CHECK(!partial.deserialize(snapshot.data(), len));
+		CHECK(partial.boards().empty() && partial.accountCount() == 0);
+	}
+	std::vector<uint8_t> bad_version = snapshot;
+	bad_version[0] = LEADERBOARD_FORMAT_VERSION + 1;
+	CHECK(!restored.deserialize(bad_version.data(), bad_version.size()));
+	CHECK(restored.boards().empty());
+
+	return checkResult("TestLeaderboard");
+}
@@ -0,0 +1,243 @@
+#include "Check.h"
+#include "SyntheticLog.h"
+#include "RevtcQuery.h"
+#include <algorithm>
+#include <random>
+
+using namespace Revtc;
+
+struct Row {
+	CombatEvent event;
+	uint32_t src;
+	uint32_t dst;
+};
+
+//The same predicates as EventQuery, written as a plain loop over events
+struct NaiveQuery {
+	struct Predicate {
+		EventColumn column;
+		int op; // 0 equals, 1 not equals, 2 between, 3 in
+		int64_t a;
+		int64_t b;
+		std::vector<uint32_t> values;
+	};
+	std::vector<Predicate> predicates;
+
+	static int64_t field(const Row& row, EventColumn column)
+	{
+		const CombatEvent& event = row.event;
+		switch (column) {
+			case EventColumn::TIME: return (int64_t)event.time;
+			case EventColumn::SRC: return row.src;
+			case EventColumn::DST: return row.dst;
+			case EventColumn::VALUE: return event.value;
+			case EventColumn::BUFF_DMG: return event.buff_dmg;
+			case EventColumn::SKILLID: return event.skillid;
+			case EventColumn::IFF: return event.iff;
+			case EventColumn::BUFF: return event.buff;
+			case EventColumn::RESULT: return event.result;
+			case EventColumn::IS_ACTIVATION: return event.is_activation;
+			case EventColumn::IS_BUFFREMOVE: return event.is_buffremove;
+			case EventColumn::IS_NINETY: return event.is_ninety;
+			case EventColumn::IS_FIFTY: return event.is_fifty;
+			case EventColumn::IS_MOVING: return event.is_moving;
+			case EventColumn::IS_STATECHANGE: return event.is_statechange;
+			case EventColumn::IS_FLANKING: return event.is_flanking;
+			case EventColumn::IS_SHIELDS: return event.is_shields;
+			case EventColumn::IS_OFFCYCLE: return event.is_offcycle;
+		}
+		return 0;
+	}
+
+	bool matches(const Row& row) const
+	{
+		for (const Predicate& predicate : predicates) {
+			const int64_t x = field(row, predicate.column);
+			bool pass = false;
+			switch (predicate.op) {
+				case 0: pass = x == predicate.a; break;
+				case 1: pass = x != predicate.a; break;
+				case 2: pass = x >= predicate.a && x < predicate.b; break;
+				case 3: pass = std::find(predicate.values.begin(), predicate.values.end(), (uint64_t)x) != predicate.values.end(); break;
+			}
+			if (!pass) {
+				return false;
+			}
+		}
+		return true;
+	}
+};
+
+static const EventColumn SUMMABLE[] = { EventColumn::TIME, EventColumn::VALUE, EventColumn::BUFF_DMG, EventColumn::SKILLID, EventColumn::RESULT };
+
+//Every aggregate of query against the naive loop over rows
+static void checkQuery(const EventQuery& query, const NaiveQuery& naive, const EventColumns& columns, const std::vector<Row>& rows)
+{
+	uint64_t count = 0;
+	std::vector<uint64_t> count_src((size_t)columns.agent_count + 1, 0);
+	std::vector<uint64_t> count_dst((size_t)columns.agent_count + 1, 0);
+	for (const Row& row : rows) {
+		if (naive.matches(row)) {
+			++count;
+			++count_src[row.src];
+			++count_dst[row.dst];
+		}
+	}
+	CHECK(query.count(columns) == count);
+	CHECK(query.countBy(columns, EventColumn::SRC) == count_src);
+	CHECK(query.countBy(columns, EventColumn::DST) == count_dst);
+
+	for (EventColumn column : SUMMABLE) {
+		int64_t total = 0;
+		std::vector<int64_t> by_src((size_t)columns.agent_count + 1, 0);
+		for (const Row& row : rows) {
+			if (naive.matches(row)) {
+				const int64_t x = NaiveQuery::field(row, column);
+				total += x;
+				by_src[row.src] += x;
+			}
+		}
+		CHECK(query.sum(columns, column) == total);
+		CHECK(query.sumBy(columns, column, EventColumn::SRC) == by_src);
+	}
+}
+
+int main()
+{
+	std::mt19937 rng(32);
+	const uint32_t agent_count = 12;
+	const uint32_t skills[] = { 740, 1187, 5000, 70000 };
+
+	//Random rows, not a whole number of query blocks, with agents outside the table (agent_count)
+	std::vector<Row> rows;
+	EventColumns columns;
+	columns.agent_count = agent_count;
+	for (size_t i = 0; i < 2048 * 3 + 777; ++i) {
+		Row row{};
+		CombatEvent& event = row.event;
+		event.time = 1000 + i * 3 + rng() % 3;
+		event.value = (int32_t)(rng() % 20001) - 1000;
+		event.buff_dmg = (int32_t)(rng() % 3) - 1;
+		event.skillid = skills[rng() % 4];
+		event.iff = rng() % 3;
+		event.buff = rng() % 2;
+		event.result = rng() % 9;
+		event.is_activation = rng() % 4 == 0 ? rng() % 5 : 0;
+		event.is_buffremove = rng() % 4 == 0 ? rng() % 4 : 0;
+		event.is_ninety = rng() % 2;
+		event.is_fifty = rng() % 2;
+		event.is_moving = rng() % 2;
+		event.is_statechange = rng() % 5 == 0 ? rng() % 40 : 0;
+		event.is_flanking = rng() % 2;
+		event.is_shields = rng() % 2;
+		event.is_offcycle = rng() % 2;
+		row.src = rng() % (agent_count + 1);
+		row.dst = rng() % (agent_count + 1);
+		rows.push_back(row);
+		columns.append(event, row.src, row.dst);
+	}
+
+	//No predicates
+	checkQuery(EventQuery(), NaiveQuery(), columns, rows);
+
+	//The documented example: sum of value for a skill, flanking, onto one agent
+	{
+		EventQuery query;
+		query.physical().equals(EventColumn::SKILLID, 5000).equals(EventColumn::IS_FLANKING, 1).in(EventColumn::DST, { 3 });
+		NaiveQuery naive;
+		naive.predicates = {
+			{ EventColumn::BUFF, 0, 0, 0, {} }, { EventColumn::IS_STATECHANGE, 0, 0, 0, {} },
+			{ EventColumn::IS_ACTIVATION, 0, 0, 0, {} }, { EventColumn::IS_BUFFREMOVE, 0, 0, 0, {} },
+			{ EventColumn::SKILLID, 0, 5000, 0, {} }, { EventColumn::IS_FLANKING, 0, 1, 0, {} }, { EventColumn::DST, 3, 0, 0, { 3 } },
+		};
+		checkQuery(query, naive, columns, rows);
+	}
+
+	//Values that do not fit the column match nothing for equals and everything for not equals
+	{
+		EventQuery query;
+		query.equals(EventColumn::IFF, 256);
+		CHECK(query.count(columns) == 0);
+		EventQuery other;
+		other.notEquals(EventColumn::RESULT, -1).between(EventColumn::VALUE, INT64_MIN, INT64_MAX);
+		CHECK(other.count(columns) == rows.size());
+		EventQuery empty;
+		empty.between(EventColumn::TIME, 5000, 5000);
+		CHECK(empty.count(columns) == 0);
+	}
+
+	//Random conjunctions over every column
+	const EventColumn all[] = {
+		EventColumn::TIME, EventColumn::SRC, EventColumn::DST, EventColumn::VALUE, EventColumn::BUFF_DMG,
+		EventColumn::SKILLID, EventColumn::IFF, EventColumn::BUFF, EventColumn::RESULT, EventColumn::IS_ACTIVATION,
+		EventColumn::IS_BUFFREMOVE, EventColumn::IS_NINETY, EventColumn::IS_FIFTY, EventColumn::IS_MOVING,
+		EventColumn::IS_STATECHANGE, EventColumn::IS_FLANKING, EventColumn::IS_SHIELDS, EventColumn::IS_OFFCYCLE,
+	};
+	for (int q = 0; q < 300; ++q) {
+		EventQuery query;
+		NaiveQuery naive;
+		const int predicates = 1 + rng() % 3;
+		for (int p = 0; p < predicates; ++p) {
+			const EventColumn column = all[rng() % (sizeof(all) / sizeof(all[0]))];
+			const Row& sample = rows[rng() % rows.size()];
+			const int64_t x = NaiveQuery::field(sample, column);
+			const int op = (column == EventColumn::SRC || column == EventColumn::DST || column == EventColumn::SKILLID) ? rng() % 4 : rng() % 3;
+			if (op == 0) {
+				query.equals(column, x);
+				naive.predicates.push_back({ column, 0, x, 0, {} });
+			}
+			else if (op == 1) {
+				query.notEquals(column, x);
+				naive.predicates.push_back({ column, 1, x, 0, {} });
+			}
+			else if (op == 2) {
+				const int64_t from = x - (int64_t)(rng() % 300);
+				const int64_t to = x + (int64_t)(rng() % 300);
+				query.between(column, from, to);
+				naive.predicates.push_back({ column, 2, from, to, {} });
+			}
+			else {
+				std::vector<uint32_t> values{ (uint32_t)x, (uint32_t)NaiveQuery::field(rows[rng() % rows.size()], column), 999999 };
+				query.in(column, values);
+				naive.predicates.push_back({ column, 3, 0, 0, values });
+			}
+		}
+		checkQuery(query, naive, columns, rows);
+	}
+
+	//Only agent columns group
+	EventQuery all_rows;
+	CHECK(all_rows.countBy(columns, EventColumn::SKILLID).empty());
+	CHECK(all_rows.sumBy(columns, EventColumn::VALUE, EventColumn::TIME).empty());
+
+	//Columns built from a parsed log agree with the parser's events
+	std::vector<unsigned char> bytes = SyntheticLog::make(5, 3000);
+	Parser parser(bytes.data(), bytes.size());
+	Log log = parser.parse();
+	CHECK(log.valid);
+	EventColumns parsed;
+	parsed.build(parser);
+	CHECK(parsed.size() == parser.events.size());
+	std::vector<Row> parsed_rows;
+	for (const CombatEvent& event : parser.events) {
+		auto src = parser.agents.find(event.src_agent);
+		auto dst = parser.agents.find(event.dst_agent);
+		parsed_rows.push_back(Row{ event,
+			src != parser.agents.end() ? src->second.index : parsed.agent_count,
+			dst != parser.agents.end() ? dst->second.index : parsed.agent_count });
+	}
+	EventQuery hits;
+	hits.physical().equals(EventColumn::SKILLID, SyntheticLog::SKILL_HIT)
+		.in(EventColumn::DST, { parser.agents.at(SyntheticLog::BOSS_ADDR).index });
+	NaiveQuery naive_hits;
+	naive_hits.predicates = {
+		{ EventColumn::BUFF, 0, 0, 0, {} }, { EventColumn::IS_STATECHANGE, 0, 0, 0, {} },
+		{ EventColumn::IS_ACTIVATION, 0, 0, 0, {} }, { EventColumn::IS_BUFFREMOVE, 0, 0, 0, {} },
+		{ EventColumn::SKILLID, 0, SyntheticLog::SKILL_HIT, 0, {} },
+		{ EventColumn::DST, 0, parser.agents.at(SyntheticLog::BOSS_ADDR).index, 0, {} },
+	};
+	CHECK(hits.count(parsed) > 0);
+	checkQuery(hits, naive_hits, parsed, parsed_rows);
+
+	return checkResult("TestQuery");
+}
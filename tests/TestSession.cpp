@@ -0,0 +1,83 @@
+#include "Check.h"
+#include "SyntheticLog.h"
+#include "RevtcSession.h"
+
+using namespace Revtc;
+
+static bool sameTotals(const AccountTotals& lhs, const AccountTotals& rhs)
+{
+	return lhs.account == rhs.account && lhs.logs == rhs.logs && lhs.duration_ms == rhs.duration_ms
+		&& lhs.physical_damage == rhs.physical_damage && lhs.condi_damage == rhs.condi_damage
+		&& lhs.boss_physical_damage == rhs.boss_physical_damage && lhs.boss_condi_damage == rhs.boss_condi_damage
+		&& lhs.buff_stack_ms == rhs.buff_stack_ms;
+}
+
+static bool sameSession(const Session& lhs, const Session& rhs)
+{
+	if (lhs.logs() != rhs.logs() || lhs.durationMs() != rhs.durationMs() || lhs.accounts().size() != rhs.accounts().size()) {
+		return false;
+	}
+	for (size_t i = 0; i < lhs.accounts().size(); ++i) {
+		if (!sameTotals(lhs.accounts()[i], rhs.accounts()[i])) {
+			return false;
+		}
+	}
+	return true;
+}
+
+int main()
+{
+	//Logs with overlapping accounts, added in one go and as two halves merged afterwards
+	Parser parser(nullptr, 0);
+	Log log;
+	Session all;
+	Session first;
+	Session second;
+	for (unsigned seed = 1; seed <= 6; ++seed) {
+		std::vector<unsigned char> bytes = SyntheticLog::make(3 + seed % 3, 3000, 17154, seed);
+		parser.parse(bytes.data(), bytes.size(), log);
+		CHECK(log.valid);
+		all.add(log);
+		(seed % 2 ? first : second).add(log);
+	}
+	CHECK(all.logs() == 6);
+	CHECK(all.accounts().size() == 5);
+	const AccountTotals* account = all.find("Account0.1234");
+	CHECK(account && account->logs == 6 && account->physical_damage > 0);
+
+	Session merged = second;
+	merged.merge(first);
+	CHECK(sameSession(merged, all));
+
+	//Snapshot round trip
+	std::vector<uint8_t> snapshot;
+	all.serialize(snapshot);
+	Session restored;
+	CHECK(restored.deserialize(snapshot.data(), snapshot.size()));
+	CHECK(sameSession(restored, all));
+	std::vector<uint8_t> again;
+	restored.serialize(again);
+	CHECK(again == snapshot);
+
+	//Restored partial sessions merge like live ones
+	std::vector<uint8_t> first_snapshot;
+	first.serialize(first_snapshot);
+	Session first_restored;
+	CHECK(first_restored.deserialize(first_snapshot.data(), first_snapshot.size()));
+	Session merged_restored = second;
+	merged_restored.merge(first_restored);
+	CHECK(sameSession(merged_restored, all));
+
+	//Truncated or unsupported snapshots are rejected and leave the session empty
+	for (size_t len = 0; len < snapshot.size(); len += 1 + len / 8) {
+		Session partial;
+		CHECK(!partial.deserialize(snapshot.data(), len));
+		CHECK(partial.logs() == 0 && partial.accounts().empty());
+	}
+	std::vector<uint8_t> bad_version = snapshot;
+	bad_version[0] = SESSION_FORMAT_VERSION + 1;
+	CHECK(!restored.deserialize(bad_version.data(), bad_version.size()));
+	CHECK(restored.accounts().empty());
+
+	return checkResult("TestSession");
+}
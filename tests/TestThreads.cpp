@@ -0,0 +1,48 @@
+#include "Check.h"
+#include "SyntheticLog.h"
+#include "RevtcJson.h"
+#include <string>
+
+using namespace Revtc;
+
+//Everything a parse produces, as written out by the JSON writer
+static std::string parseWith(const std::vector<unsigned char>& bytes, unsigned threads)
+{
+	Parser parser(bytes.data(), bytes.size());
+	parser.threads = threads;
+	Log log = parser.parse();
+	CHECK(log.valid);
+	std::string json(writeJson(log, nullptr, 0, JsonOptions(), &parser), '\0');
+	writeJson(log, &json[0], json.size(), JsonOptions(), &parser);
+	return json;
+}
+
+int main()
+{
+	//About 350k events and 30 players, so every thread count splits both the event passes
+	//(Parser::MIN_CHUNK_EVENTS per chunk) and the boon replay (64 tracks per worker)
+	std::vector<unsigned char> bytes = SyntheticLog::make(30, 200000, 17154, 3);
+	const std::string expected = parseWith(bytes, 1);
+	CHECK(expected.find("\"valid\":true") != std::string::npos);
+
+	for (unsigned threads : { 2u, 3u, 4u, 7u }) {
+		const std::string json = parseWith(bytes, threads);
+		CHECK(json == expected);
+		if (json != expected) {
+			std::fprintf(stderr, "  %u threads differ\n", threads);
+		}
+	}
+
+	//A Parser reused across logs and thread counts gives the same results as fresh ones
+	Parser parser(nullptr, 0);
+	Log log;
+	for (unsigned threads : { 7u, 1u, 4u }) {
+		parser.threads = threads;
+		parser.parse(bytes.data(), bytes.size(), log);
+		std::string json(writeJson(log, nullptr, 0, JsonOptions(), &parser), '\0');
+		writeJson(log, &json[0], json.size(), JsonOptions(), &parser);
+		CHECK(json == expected);
+	}
+
+	return checkResult("TestThreads");
+}
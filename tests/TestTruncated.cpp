@@ -0,0 +1,102 @@
+#include "Check.h"
+#include "SyntheticLog.h"
+#include "Revtc.h"
+#include "RevtcFingerprint.h"
+#include "RevtcWvw.h"
+#include <string>
+
+using namespace Revtc;
+
+//Parses the first len bytes from a buffer of exactly that size, so reads past the end hit the sanitizers
+static Log parsePrefix(const std::vector<unsigned char>& bytes, size_t len, size_t* event_count = nullptr)
+{
+	std::vector<unsigned char> prefix(bytes.begin(), bytes.begin() + len);
+	Parser parser(prefix.data(), prefix.size());
+	Log log = parser.parse();
+	if (event_count) {
+		*event_count = parser.events.size();
+	}
+	return log;
+}
+
+int main()
+{
+	std::vector<unsigned char> bytes = SyntheticLog::make(3, 500);
+	uint32_t agent_count;
+	memcpy(&agent_count, &bytes[16], sizeof(agent_count));
+	const size_t agents_at = 20;
+	const size_t skills_at = agents_at + (size_t)agent_count * 96;
+	uint32_t skill_count;
+	memcpy(&skill_count, &bytes[skills_at], sizeof(skill_count));
+	const size_t events_at = skills_at + 4 + (size_t)skill_count * 68;
+	const size_t stride = sizeof(CombatEvent);
+	CHECK((bytes.size() - events_at) % stride == 0);
+	const size_t full_events = (bytes.size() - events_at) / stride;
+
+	size_t events = 0;
+	Log full = parsePrefix(bytes, bytes.size(), &events);
+	CHECK(full.valid && full.error.empty());
+	CHECK(events == full_events);
+
+	//Header: the magic, then the version, revision, boss and agent count
+	for (size_t len = 0; len < agents_at; ++len) {
+		Log log = parsePrefix(bytes, len);
+		CHECK(!log.valid);
+		CHECK(log.error == (len < 4 ? "Corrupted or otherwise invalid EVTC file." : "EVTC header is truncated."));
+		CHECK(log.players.empty());
+	}
+
+	//Agent table, cut at record edges and inside records
+	for (size_t len = agents_at; len < skills_at; len += 7) {
+		Log log = parsePrefix(bytes, len);
+		CHECK(!log.valid);
+		CHECK(log.error == "Agent table is truncated.");
+		CHECK(log.players.empty());
+	}
+
+	//Skill count and skill table
+	for (size_t len = skills_at; len < events_at; ++len) {
+		Log log = parsePrefix(bytes, len);
+		CHECK(!log.valid);
+		CHECK(log.error == "Skill table is truncated.");
+	}
+
+	//Events: whole records before the cut are kept, a partial record is dropped and noted
+	for (size_t cut : { (size_t)0, (size_t)1, stride / 2, stride - 1 }) {
+		for (size_t whole : { (size_t)0, (size_t)1, full_events / 2, full_events - 1 }) {
+			const size_t len = events_at + whole * stride + cut;
+			Log log = parsePrefix(bytes, len, &events);
+			CHECK(events == whole);
+			if (cut) {
+				CHECK(log.error == "Event section ends in a partial record, which was ignored.");
+			}
+			if (whole == full_events - 1 && !cut) {
+				//Only the log end event is missing
+				CHECK(log.valid);
+				CHECK(log.players.size() == full.players.size());
+			}
+		}
+	}
+	Log partial = parsePrefix(bytes, bytes.size() - 1, &events);
+	CHECK(events == full_events - 1);
+	CHECK(partial.valid && !partial.error.empty());
+
+	//The other readers of raw logs stop at the end of every prefix as well
+	WvwParser wvw_parser;
+	WvwLog wvw;
+	for (size_t len = 0; len < bytes.size(); len += len < events_at ? 1 : 13) {
+		std::vector<unsigned char> prefix(bytes.begin(), bytes.begin() + len);
+		Fingerprint fp = fingerprint(prefix.data(), prefix.size());
+		CHECK(fp.valid == (len >= events_at));
+		wvw_parser.parse(prefix.data(), prefix.size(), wvw);
+		if (len < agents_at) {
+			CHECK(!wvw.valid);
+		}
+		if (len >= events_at) {
+			CHECK(wvw.valid);
+			CHECK(wvw.event_count == (len - events_at) / stride);
+		}
+	}
+
+	return checkResult("TestTruncated");
+}